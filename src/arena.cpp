@@ -0,0 +1,80 @@
+#include "arena.h"
+
+#include <algorithm>
+#include <new>
+
+Arena::Arena(size_t blockSize) :
+	m_blockSize(alignedSize(blockSize))
+{
+}
+
+Arena::~Arena()
+{
+	while (m_current != nullptr)
+	{
+		Block* previous = m_current->previous;
+		freeBlock(m_current);
+		m_current = previous;
+	}
+}
+
+void Arena::addBlock(size_t bytes)
+{
+	const size_t size = std::max(alignedSize(bytes), m_blockSize);
+	Block* block = (Block*)::operator new(kHeaderSize + size, std::align_val_t(kAlignment));
+	block->previous = m_current;
+	block->size = size;
+	m_current = block;
+	m_offset = 0;
+}
+
+void Arena::freeBlock(Block* block)
+{
+	::operator delete(block, std::align_val_t(kAlignment));
+}
+
+void Arena::reserve(size_t bytes)
+{
+	if (m_current == nullptr || m_current->size - m_offset < bytes) addBlock(bytes);
+}
+
+void* Arena::allocate(size_t bytes)
+{
+	bytes = alignedSize(bytes);
+	reserve(bytes);
+
+	void* allocation = (char*)m_current + kHeaderSize + m_offset;
+	m_offset += bytes;
+	m_bytesUsed += bytes;
+	return allocation;
+}
+
+void Arena::reset()
+{
+	// Keep the largest block, it is the most likely to fit the next allocations on its own
+	Block* largest = m_current;
+	for (Block* block = m_current; block != nullptr; block = block->previous)
+	{
+		if (block->size > largest->size) largest = block;
+	}
+
+	Block* block = m_current;
+	while (block != nullptr)
+	{
+		Block* previous = block->previous;
+		if (block != largest) freeBlock(block);
+		block = previous;
+	}
+
+	m_current = largest;
+	if (m_current != nullptr) m_current->previous = nullptr;
+	m_offset = 0;
+	m_bytesUsed = 0;
+}
+
+size_t Arena::getBlockCount() const
+{
+	size_t count = 0;
+	for (Block* block = m_current; block != nullptr; block = block->previous) count++;
+	return count;
+}
@@ -0,0 +1,98 @@
+#ifndef INCLUDE_ARENA
+#define INCLUDE_ARENA
+
+#include <cstddef>
+#include <type_traits>
+
+/*
+* @brief Monotonic allocator: carves aligned arrays out of large blocks, and frees them all at once.
+*
+* Nothing is freed one array at a time, so it suits data built once and dropped together, like the
+* arrays of a Mesh. Only trivially destructible types are stored, their destructors are never run.
+*/
+class Arena
+{
+public:
+	// A cache line, and the widest SIMD register
+	static constexpr size_t kAlignment = 64;
+
+	/*
+	* @param blockSize The size of the blocks allocated when the current one is full, larger requests getting a block of their own.
+	*/
+	explicit Arena(size_t blockSize = 64 * 1024);
+
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+
+	/*
+	* @brief Frees every block.
+	*/
+	~Arena();
+
+	/*
+	* @brief Makes sure the next allocations of up to bytes in total, each aligned on kAlignment, fit in a single block.
+	*
+	* @param bytes The total size of the next allocations, with their alignment padding.
+	*/
+	void reserve(size_t bytes);
+
+	/*
+	* @brief Get uninitialized memory, aligned on kAlignment, valid until reset() or the destruction of the Arena.
+	*/
+	void* allocate(size_t bytes);
+
+	/*
+	* @brief Get an uninitialized array, aligned on kAlignment, valid until reset() or the destruction of the Arena.
+	*/
+	template <typename T>
+	T* allocateArray(size_t count)
+	{
+		static_assert(std::is_trivially_destructible<T>::value, "The arena never runs destructors");
+		static_assert(alignof(T) <= kAlignment, "The arena does not align past kAlignment");
+		return (T*)allocate(sizeof(T) * count);
+	}
+
+	/*
+	* @brief Get the size an allocation takes in a block, its alignment padding included.
+	*/
+	inline static size_t alignedSize(size_t bytes) { return (bytes + kAlignment - 1) / kAlignment * kAlignment; }
+
+	/*
+	* @brief Invalidates every allocation at once. The largest block is kept for the next ones, the others are freed.
+	*/
+	void reset();
+
+	/*
+	* @brief Get the amount of blocks, i.e. of heap allocations, held by the arena.
+	*/
+	size_t getBlockCount() const;
+
+	/*
+	* @brief Get the amount of bytes handed out since the last reset(), alignment padding included.
+	*/
+	inline size_t getBytesUsed() const { return m_bytesUsed; }
+
+private:
+	// Each block starts with this header, the allocations follow
+	struct Block
+	{
+		Block* previous;
+		size_t size; // Of the allocations part
+	};
+
+	static constexpr size_t kHeaderSize = (sizeof(Block) + kAlignment - 1) / kAlignment * kAlignment;
+
+	size_t m_blockSize;
+	Block* m_current = nullptr; // The block being filled, the others follow its previous links
+	size_t m_offset = 0;        // Of the next allocation in m_current
+	size_t m_bytesUsed = 0;
+
+	/*
+	* @brief Allocates a block able to hold at least bytes, and makes it the current one.
+	*/
+	void addBlock(size_t bytes);
+
+	static void freeBlock(Block* block);
+};
+
+#endif
@@ -0,0 +1,51 @@
+#include "bakedSpheres.h"
+#include "uvSphere.h"
+
+namespace
+{
+	template <size_t Resolution>
+	struct BakedSphere
+	{
+		PackedVertex vertices[UVSphere::vertexCount(Resolution)];
+		std::uint16_t indices[UVSphere::indexCount(Resolution)];
+	};
+
+	template <size_t Resolution>
+	constexpr BakedSphere<Resolution> bake()
+	{
+		static_assert(UVSphere::vertexCount(Resolution) < 0xFFFF, "Baked spheres use 16 bits indices");
+
+		BakedSphere<Resolution> sphere{};
+		UVSphere::generate(Resolution, sphere.vertices, sphere.indices);
+		return sphere;
+	}
+
+	// Evaluated by the compiler, nothing is left to compute at startup
+	// Larger resolutions would slow the build down for levels that are rarely drawn
+	constexpr BakedSphere<8> kSphere8 = bake<8>();
+	constexpr BakedSphere<16> kSphere16 = bake<16>();
+	constexpr BakedSphere<32> kSphere32 = bake<32>();
+	constexpr BakedSphere<64> kSphere64 = bake<64>();
+	constexpr BakedSphere<128> kSphere128 = bake<128>();
+
+	const size_t kResolutions[] = { 8, 16, 32, 64, 128 };
+}
+
+bool BakedSpheres::find(size_t resolution, const PackedVertex*& vertices, const std::uint16_t*& indices)
+{
+	switch (resolution)
+	{
+	case 8: vertices = kSphere8.vertices; indices = kSphere8.indices; return true;
+	case 16: vertices = kSphere16.vertices; indices = kSphere16.indices; return true;
+	case 32: vertices = kSphere32.vertices; indices = kSphere32.indices; return true;
+	case 64: vertices = kSphere64.vertices; indices = kSphere64.indices; return true;
+	case 128: vertices = kSphere128.vertices; indices = kSphere128.indices; return true;
+	}
+	return false;
+}
+
+const size_t* BakedSpheres::getResolutions(size_t& count)
+{
+	count = sizeof(kResolutions) / sizeof(kResolutions[0]);
+	return kResolutions;
+}
@@ -0,0 +1,36 @@
+#ifndef INCLUDE_BAKEDSPHERES
+#define INCLUDE_BAKEDSPHERES
+
+#include "meshUtility.h"
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+* @brief The UV spheres of the common resolutions, generated at build time by UVSphere and stored in the binary.
+*
+* Their triangles are lists of 16 bits indices, ready to be uploaded as they are.
+*/
+class BakedSpheres
+{
+public:
+	/*
+	* @brief Get the baked sphere of a resolution.
+	*
+	* @param resolution The resolution of the sphere.
+	* @param vertices Receives the UVSphere::vertexCount(resolution) vertices.
+	* @param indices Receives the UVSphere::indexCount(resolution) indices.
+	*
+	* @return Whether that resolution is baked. If not, vertices and indices are left untouched.
+	*/
+	static bool find(size_t resolution, const PackedVertex*& vertices, const std::uint16_t*& indices);
+
+	/*
+	* @brief Get the baked resolutions, from the coarsest to the finest.
+	*
+	* @param count Receives the amount of resolutions.
+	*/
+	static const size_t* getResolutions(size_t& count);
+};
+
+#endif
@@ -0,0 +1,281 @@
+#include "barnesHut.h"
+
+#include <algorithm>
+#include <cmath>
+
+// The cells of this level are built as independent subtrees on the workers, up to 64 of them
+static const int kSplitLevel = 2;
+
+// The bodies of dense regions take longer, many small parts even the load of the workers
+static const size_t kForceParts = 256;
+
+// Spreads the 21 lowest bits of x three bits apart, to interleave them with the two other axes
+static std::uint64_t spreadBits(std::uint64_t x)
+{
+	x &= 0x1fffff;
+	x = (x | x << 32) & 0x1f00000000ffffull;
+	x = (x | x << 16) & 0x1f0000ff0000ffull;
+	x = (x | x << 8) & 0x100f00f00f00f00full;
+	x = (x | x << 4) & 0x10c30c30c30c30c3ull;
+	x = (x | x << 2) & 0x1249249249249249ull;
+	return x;
+}
+
+BarnesHut::BarnesHut(ThreadPool* threadPool) :
+	m_threadPool(threadPool)
+{
+}
+
+void BarnesHut::build(const glm::dvec3* positions, const double* masses, size_t count)
+{
+	m_nodes.clear();
+	m_keys.resize(count);
+	m_positions.resize(count);
+	m_masses.resize(count);
+	if (count == 0) return;
+
+	const size_t partCount = m_threadPool != nullptr ? std::min(count, 4 * m_threadPool->getThreadCount()) : 1;
+
+	// The root cube bounds every body
+	std::vector<glm::dvec3> partLow(partCount, positions[0]), partHigh(partCount, positions[0]);
+	forEachPart(count, partCount, [&](size_t part, size_t first, size_t last) {
+		for (size_t i = first; i < last; i++)
+		{
+			partLow[part] = glm::min(partLow[part], positions[i]);
+			partHigh[part] = glm::max(partHigh[part], positions[i]);
+		}
+	});
+	glm::dvec3 low = partLow[0], high = partHigh[0];
+	for (size_t part = 1; part < partCount; part++)
+	{
+		low = glm::min(low, partLow[part]);
+		high = glm::max(high, partHigh[part]);
+	}
+	const glm::dvec3 extent = high - low;
+	m_rootSize = std::max(std::max(extent.x, extent.y), extent.z);
+	if (m_rootSize <= 0.0) m_rootSize = 1.0;
+
+	// The body index breaks the ties, so the order is the same however the sort is split
+	const double cellsPerUnit = (1 << kMaxDepth) / m_rootSize;
+	const double maxCell = (1 << kMaxDepth) - 1;
+	forEachPart(count, partCount, [&](size_t, size_t first, size_t last) {
+		for (size_t i = first; i < last; i++)
+		{
+			const glm::dvec3 cell = glm::clamp((positions[i] - low) * cellsPerUnit, 0.0, maxCell);
+			const std::uint64_t key = spreadBits((std::uint64_t)cell.x) | spreadBits((std::uint64_t)cell.y) << 1 | spreadBits((std::uint64_t)cell.z) << 2;
+			m_keys[i] = std::make_pair(key, (std::uint32_t)i);
+		}
+	});
+	sortKeys(partCount);
+
+	// Gathered in Morton order, the bodies of a leaf are contiguous in memory
+	forEachPart(count, partCount, [&](size_t, size_t first, size_t last) {
+		for (size_t i = first; i < last; i++)
+		{
+			m_positions[i] = positions[m_keys[i].second];
+			m_masses[i] = masses[m_keys[i].second];
+		}
+	});
+
+	std::vector<Subtree> subtrees;
+	buildNode(m_nodes, 0, count, 0, m_threadPool != nullptr ? &subtrees : nullptr);
+	if (subtrees.empty()) return;
+
+	// The subtrees are built apart, then appended after the top levels
+	const size_t topCount = m_nodes.size();
+	if (m_subtreeNodes.size() < subtrees.size()) m_subtreeNodes.resize(subtrees.size());
+	forEachPart(subtrees.size(), subtrees.size(), [&](size_t subtree, size_t, size_t) {
+		m_subtreeNodes[subtree].clear();
+		buildNode(m_subtreeNodes[subtree], subtrees[subtree].first, subtrees[subtree].last, kSplitLevel, nullptr);
+	});
+
+	std::vector<size_t> offsets(subtrees.size());
+	size_t nodeCount = topCount;
+	for (size_t subtree = 0; subtree < subtrees.size(); subtree++)
+	{
+		offsets[subtree] = nodeCount;
+		nodeCount += m_subtreeNodes[subtree].size() - 1;
+	}
+	m_nodes.resize(nodeCount);
+
+	// The root of a subtree replaces the cell it was built for, the others follow the top levels
+	forEachPart(subtrees.size(), subtrees.size(), [&](size_t subtree, size_t, size_t) {
+		const std::vector<Node>& nodes = m_subtreeNodes[subtree];
+		const size_t offset = offsets[subtree];
+		for (size_t i = 0; i < nodes.size(); i++)
+		{
+			Node node = nodes[i];
+			for (std::int32_t& child : node.children)
+			{
+				if (child >= 0) child = (std::int32_t)(offset + child - 1);
+			}
+			m_nodes[i == 0 ? subtrees[subtree].node : offset + i - 1] = node;
+		}
+	});
+
+	// The top levels were summarized without their subtrees, their children come after them
+	for (size_t i = topCount; i-- > 0;) summarizeNode(m_nodes, (std::int32_t)i);
+}
+
+void BarnesHut::sortKeys(size_t partCount)
+{
+	if (partCount <= 1)
+	{
+		std::sort(m_keys.begin(), m_keys.end());
+		return;
+	}
+
+	const size_t count = m_keys.size();
+	forEachPart(count, partCount, [&](size_t, size_t first, size_t last) {
+		std::sort(m_keys.begin() + first, m_keys.begin() + last);
+	});
+
+	for (size_t width = 1; width < partCount; width *= 2)
+	{
+		const size_t mergeCount = (partCount + 2 * width - 1) / (2 * width);
+		forEachPart(mergeCount, mergeCount, [&](size_t merge, size_t, size_t) {
+			const size_t firstPart = 2 * width * merge;
+			const size_t middlePart = std::min(firstPart + width, partCount), lastPart = std::min(firstPart + 2 * width, partCount);
+			std::inplace_merge(m_keys.begin() + count * firstPart / partCount, m_keys.begin() + count * middlePart / partCount,
+				m_keys.begin() + count * lastPart / partCount);
+		});
+	}
+}
+
+std::int32_t BarnesHut::buildNode(std::vector<Node>& nodes, size_t first, size_t last, int level, std::vector<Subtree>* subtrees) const
+{
+	const std::int32_t index = (std::int32_t)nodes.size();
+	Node node;
+	node.centerOfMass = glm::dvec3(0.0);
+	node.mass = 0.0;
+	node.size = std::ldexp(m_rootSize, -level);
+	node.first = (std::uint32_t)first;
+	node.count = (std::uint32_t)(last - first);
+	node.leaf = last - first <= kLeafSize || level == kMaxDepth;
+	std::fill(std::begin(node.children), std::end(node.children), -1);
+	nodes.push_back(node);
+
+	if (!node.leaf && subtrees != nullptr && level == kSplitLevel)
+	{
+		subtrees->push_back(Subtree{ index, first, last });
+		return index;
+	}
+
+	if (!node.leaf)
+	{
+		// The bodies of each octant follow each other, in octant order
+		const int shift = 3 * (kMaxDepth - 1 - level);
+		size_t begin = first;
+		for (int octant = 0; octant < 8 && begin < last; octant++)
+		{
+			const size_t end = std::partition_point(m_keys.begin() + begin, m_keys.begin() + last,
+				[&](const std::pair<std::uint64_t, std::uint32_t>& key) { return (int)((key.first >> shift) & 7) <= octant; }) - m_keys.begin();
+			if (end > begin)
+			{
+				const std::int32_t child = buildNode(nodes, begin, end, level + 1, subtrees);
+				nodes[index].children[octant] = child; // nodes may have moved
+			}
+			begin = end;
+		}
+	}
+
+	summarizeNode(nodes, index);
+	return index;
+}
+
+void BarnesHut::summarizeNode(std::vector<Node>& nodes, std::int32_t index) const
+{
+	Node& node = nodes[index];
+	double mass = 0.0;
+	glm::dvec3 weightedPosition(0.0);
+	if (node.leaf)
+	{
+		for (size_t i = node.first; i < node.first + node.count; i++)
+		{
+			mass += m_masses[i];
+			weightedPosition += m_masses[i] * m_positions[i];
+		}
+	}
+	else
+	{
+		for (std::int32_t child : node.children)
+		{
+			if (child < 0) continue;
+			mass += nodes[child].mass;
+			weightedPosition += nodes[child].mass * nodes[child].centerOfMass;
+		}
+	}
+
+	node.mass = mass;
+	node.centerOfMass = mass > 0.0 ? weightedPosition / mass : m_positions[node.first];
+}
+
+size_t BarnesHut::computeAccelerations(glm::dvec3* accelerations) const
+{
+	if (m_nodes.empty()) return 0;
+
+	const size_t count = m_positions.size();
+	const size_t partCount = std::min(count, kForceParts);
+	std::vector<size_t> partInteractions(partCount, 0);
+	forEachPart(count, partCount, [&](size_t part, size_t first, size_t last) {
+		size_t interactions = 0;
+		for (size_t i = first; i < last; i++)
+		{
+			accelerations[m_keys[i].second] = m_gravitationalConstant * accelerate(i, interactions);
+		}
+		partInteractions[part] = interactions;
+	});
+
+	size_t interactions = 0;
+	for (size_t partInteraction : partInteractions) interactions += partInteraction;
+	return interactions;
+}
+
+glm::dvec3 BarnesHut::accelerate(size_t body, size_t& interactions) const
+{
+	const glm::dvec3 position = m_positions[body];
+	const double openingAngle2 = m_openingAngle * m_openingAngle;
+	const double softening2 = m_softening * m_softening;
+	glm::dvec3 acceleration(0.0);
+
+	// Each level opened pushes at most 8 children for 1 popped
+	std::int32_t stack[8 * (kMaxDepth + 1)];
+	int top = 0;
+	stack[top++] = 0;
+	while (top > 0)
+	{
+		const Node& node = m_nodes[stack[--top]];
+		if (node.mass == 0.0) continue; // Only test particles
+
+		if (node.leaf)
+		{
+			for (size_t i = node.first; i < node.first + node.count; i++)
+			{
+				if (i == body) continue;
+				const glm::dvec3 offset = m_positions[i] - position;
+				const double inverseDistance = 1.0 / std::sqrt(glm::dot(offset, offset) + softening2);
+				acceleration += (m_masses[i] * inverseDistance * inverseDistance * inverseDistance) * offset;
+				interactions++;
+			}
+			continue;
+		}
+
+		// Far enough, the whole cell pulls from its center of mass
+		const glm::dvec3 offset = node.centerOfMass - position;
+		const double distance2 = glm::dot(offset, offset);
+		if (node.size * node.size < openingAngle2 * distance2)
+		{
+			const double inverseDistance = 1.0 / std::sqrt(distance2 + softening2);
+			acceleration += (node.mass * inverseDistance * inverseDistance * inverseDistance) * offset;
+			interactions++;
+			continue;
+		}
+
+		// Pushed backward, so that the octants are summed in order
+		for (int octant = 7; octant >= 0; octant--)
+		{
+			if (node.children[octant] >= 0) stack[top++] = node.children[octant];
+		}
+	}
+	return acceleration;
+}
@@ -0,0 +1,153 @@
+#ifndef INCLUDE_BARNESHUT
+#define INCLUDE_BARNESHUT
+
+#include "threadPool.h"
+
+#include <dep/glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/*
+* @brief Approximates the gravity between many bodies in O(n log n) with an octree of their masses.
+*
+* The bodies are sorted along a Morton curve, so every cell of the octree is a contiguous range of
+* them. A cell seen under less than the opening angle acts as a single mass at its center of mass,
+* the closer ones are opened, down to leaves of at most kLeafSize bodies summed directly.
+*
+* The tree is built and the forces are evaluated on the workers of a ThreadPool. The cells and the
+* summations do not depend on how the work is split: the accelerations are bit-identical with any
+* amount of workers, or without any.
+*/
+class BarnesHut
+{
+public:
+	// Bodies per leaf, summed directly: fewer cells to open, and a tight loop over contiguous bodies
+	static constexpr size_t kLeafSize = 8;
+
+	// Levels below the root, the 21 bits per axis of a 64-bit Morton code
+	static constexpr int kMaxDepth = 21;
+
+	/*
+	* @param threadPool The workers building the tree and evaluating the forces, nullptr to do it on the calling thread.
+	*/
+	explicit BarnesHut(ThreadPool* threadPool = nullptr);
+
+	/*
+	* @brief Sets the largest size to distance ratio of a cell approximated by its center of mass.
+	*
+	* @param openingAngle 0 sums every pair exactly, 0.5 is usual, 1 is fast but coarse.
+	*/
+	inline void setOpeningAngle(double openingAngle) { m_openingAngle = openingAngle; }
+	inline double getOpeningAngle() const { return m_openingAngle; }
+
+	/*
+	* @brief Sets the distance below which the gravity is smoothed, so that close encounters do not diverge.
+	*/
+	inline void setSoftening(double softening) { m_softening = softening; }
+
+	inline void setGravitationalConstant(double gravitationalConstant) { m_gravitationalConstant = gravitationalConstant; }
+
+	/*
+	* @brief Builds the octree of the bodies.
+	*
+	* @param positions The positions of the bodies.
+	* @param masses The masses of the bodies, 0 for a test particle attracted by the others but not attracting them.
+	* @param count The amount of bodies.
+	*/
+	void build(const glm::dvec3* positions, const double* masses, size_t count);
+
+	/*
+	* @brief Computes the acceleration of every body given to the last build(), from all the others.
+	*
+	* @param accelerations Where to write the acceleration of each body, in the order they were given.
+	*
+	* @return The amount of interactions evaluated, with bodies and with cells.
+	*/
+	size_t computeAccelerations(glm::dvec3* accelerations) const;
+
+	inline size_t getNodeCount() const { return m_nodes.size(); }
+
+private:
+	struct Node
+	{
+		glm::dvec3 centerOfMass;
+		double mass;
+		double size;              // Of the edge of its cube
+		std::uint32_t first;      // First body of the cell, in Morton order
+		std::uint32_t count;      // Bodies in the cell
+		bool leaf;                // Whether its bodies are summed directly
+		std::int32_t children[8]; // By octant, -1 where empty
+	};
+
+	// A cell left to build on the workers
+	struct Subtree
+	{
+		std::int32_t node;
+		size_t first, last;
+	};
+
+	ThreadPool* m_threadPool;
+	double m_openingAngle = 0.5;
+	double m_softening = 1e-3;
+	double m_gravitationalConstant = 1.0;
+
+	// The bodies of the last build(), in Morton order, and their index in the order they were given
+	std::vector<std::pair<std::uint64_t, std::uint32_t>> m_keys;
+	std::vector<glm::dvec3> m_positions;
+	std::vector<double> m_masses;
+
+	// Depth-first, the root first
+	std::vector<Node> m_nodes;
+	std::vector<std::vector<Node>> m_subtreeNodes;
+	double m_rootSize = 0.0;
+
+	/*
+	* @brief Runs a function on every part of a range, on the workers if there are any.
+	*
+	* @param count The size of the range.
+	* @param partCount The amount of parts the range is cut in, whatever the amount of workers.
+	* @param function The function to run, taking the part, its first index and one past its last.
+	*/
+	template <typename F>
+	void forEachPart(size_t count, size_t partCount, F function) const
+	{
+		auto runPart = [&](size_t part) { function(part, count * part / partCount, count * (part + 1) / partCount); };
+		if (m_threadPool != nullptr)
+		{
+			m_threadPool->parallelFor(partCount, runPart);
+		}
+		else
+		{
+			for (size_t part = 0; part < partCount; part++) runPart(part);
+		}
+	}
+
+	/*
+	* @brief Sorts m_keys, in parts sorted in parallel then merged two by two.
+	*/
+	void sortKeys(size_t partCount);
+
+	/*
+	* @brief Appends the cell of a range of bodies and its descendants to nodes.
+	*
+	* @param subtrees Where to leave the cells at kSplitLevel for the workers, nullptr to build them too.
+	*
+	* @return The index of the cell in nodes.
+	*/
+	std::int32_t buildNode(std::vector<Node>& nodes, size_t first, size_t last, int level, std::vector<Subtree>* subtrees) const;
+
+	/*
+	* @brief Computes the mass and center of mass of a cell from its children, or its bodies for a leaf.
+	*/
+	void summarizeNode(std::vector<Node>& nodes, std::int32_t index) const;
+
+	/*
+	* @brief Computes the acceleration of a body, in Morton order, without the gravitational constant.
+	*/
+	glm::dvec3 accelerate(size_t body, size_t& interactions) const;
+};
+
+#endif
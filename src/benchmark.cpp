@@ -0,0 +1,931 @@
+#include "benchmark.h"
+#include "barnesHut.h"
+#include "bakedSpheres.h"
+#include "ephemeris.h"
+#include "fixedTimestep.h"
+#include "frameStats.h"
+#include "keplerKernel.h"
+#include "mesh.h"
+#include "meshFile.h"
+#include "meshUtility.h"
+#include "particleSystem.h"
+#include "threadPool.h"
+#include "vertexKernel.h"
+
+#include <dep/glm/glm.hpp>
+#include <dep/glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	// Runs the function repeatedly for at least minSeconds, and returns the average duration of a run in seconds
+	template <typename F>
+	double timeIt(F function, double minSeconds = 0.2)
+	{
+		function(); // Warm up the caches
+		int runs = 0;
+		const Clock::time_point start = Clock::now();
+		double elapsed = 0.0;
+		do
+		{
+			function();
+			runs++;
+			elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+		} while (elapsed < minSeconds);
+		return elapsed / runs;
+	}
+
+	// Points spread on the unit sphere, as many as Mesh::genSphere(resolution) generates
+	std::vector<glm::vec3> unitSpherePoints(size_t resolution)
+	{
+		const size_t count = (resolution + 1) * (resolution - 2) + 2;
+		std::vector<glm::vec3> points(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			const float theta = 3.14159265f * (i + 0.5f) / count;
+			const float phi = 2.39996323f * i; // Golden angle
+			points[i] = glm::vec3(sin(theta) * cos(phi), sin(theta) * sin(phi), cos(theta));
+		}
+		return points;
+	}
+
+	// The former Mesh::transform() loop, over arrays of glm::vec3
+	void transformAoS(const glm::mat4& matxTrans, const glm::vec3& selfCenter, const glm::vec3& sunCenter,
+		const std::vector<glm::vec3>& local, std::vector<glm::vec3>& positions, std::vector<glm::vec3>& normals, std::vector<glm::vec3>& light)
+	{
+		for (size_t i = 0; i < local.size(); i++) {
+			glm::vec3 pointCoord = glm::vec3(matxTrans * glm::vec4{ local[i], 1 });
+			positions[i] = pointCoord;
+			normals[i] = glm::normalize(pointCoord - selfCenter);
+
+			glm::vec3 lightVector = sunCenter - pointCoord;
+			lightVector = 1.33203125f * glm::normalize(lightVector) / (float)pow(glm::length(lightVector), 0.125);
+			light[i] = lightVector;
+		}
+	}
+
+	int benchVertexKernel()
+	{
+		const glm::vec3 selfCenter(10.0f, 0.5f, -3.0f), sunCenter(0.0f);
+		const glm::mat4 matxTrans =
+			glm::translate(glm::mat4(1.0f), selfCenter) *
+			glm::rotate(glm::mat4(1.0f), 0.41f, glm::vec3(0.3f, 0.9f, 0.1f)) *
+			glm::scale(glm::mat4(1.0f), glm::vec3(0.5f));
+
+		std::printf("%-10s %10s %14s", "resolution", "vertices", "AoS (ns/vtx)");
+		for (int impl = VertexKernel::Scalar; impl <= VertexKernel::AVX2; impl++)
+			std::printf(" %14s", VertexKernel::getName((VertexKernel::Implementation)impl));
+		std::printf(" %12s\n", "max error");
+
+		const size_t resolutions[] = { 16, 64, 256, 512, 1024 };
+		for (size_t resolution : resolutions)
+		{
+			const std::vector<glm::vec3> local = unitSpherePoints(resolution);
+			const size_t count = local.size();
+
+			std::vector<glm::vec3> aosPositions(count), aosNormals(count), aosLight(count);
+			const double aosTime = timeIt([&]() {
+				transformAoS(matxTrans, selfCenter, sunCenter, local, aosPositions, aosNormals, aosLight);
+			});
+			std::printf("%-10zu %10zu %14.2f", resolution, count, aosTime * 1e9 / count);
+
+			VertexSoA soaLocal, positions, normals, light;
+			soaLocal.resize(count);
+			positions.resize(count);
+			normals.resize(count);
+			light.resize(count);
+			for (size_t i = 0; i < count; i++) soaLocal.set(i, local[i]);
+
+			float maxError = 0.0f;
+			for (int impl = VertexKernel::Scalar; impl <= VertexKernel::AVX2; impl++)
+			{
+				const VertexKernel::Implementation implementation = (VertexKernel::Implementation)impl;
+				if (!VertexKernel::isSupported(implementation))
+				{
+					std::printf(" %14s", "n/a");
+					continue;
+				}
+
+				const double time = timeIt([&]() {
+					VertexKernel::transform(implementation, matxTrans, selfCenter, sunCenter, soaLocal, positions, normals, light);
+				});
+				std::printf(" %8.2f (x%3.1f)", time * 1e9 / count, aosTime / time);
+
+				for (size_t i = 0; i < count; i++)
+				{
+					maxError = std::max(maxError, glm::length(positions.get(i) - aosPositions[i]));
+					maxError = std::max(maxError, glm::length(normals.get(i) - aosNormals[i]));
+					maxError = std::max(maxError, glm::length(light.get(i) - aosLight[i]));
+				}
+			}
+			std::printf(" %12.3g\n", maxError);
+		}
+		std::printf("Runtime selection: %s\n", VertexKernel::getName(VertexKernel::detect()));
+		return EXIT_SUCCESS;
+	}
+
+	int benchSphereIndices()
+	{
+		std::printf("%-10s %-6s %10s %10s %6s %12s %12s %12s %10s\n",
+			"resolution", "mode", "vertices", "indices", "type", "index bytes", "ACMR before", "ACMR after", "init (ms)");
+
+		const size_t resolutions[] = { 8, 16, 32, 64, 128, 256, 512 };
+		for (size_t resolution : resolutions)
+		{
+			for (int useStrips = 0; useStrips <= 1; useStrips++)
+			{
+				// Only the CPU side of the Mesh is built, nothing is sent to the GPU
+				Mesh mesh;
+				const Clock::time_point start = Clock::now();
+				mesh.generate(resolution, useStrips != 0);
+				const double initTime = std::chrono::duration<double>(Clock::now() - start).count();
+				mesh.computeStatistics();
+
+				const size_t indexSize = mesh.getIndexType() == GL_UNSIGNED_SHORT ? 2 : 4;
+				std::printf("%-10zu %-6s %10zu %10zu %6s %12zu %12.3f %12.3f %10.2f\n",
+					resolution, useStrips ? "strip" : "list", mesh.getVertexCount(),
+					mesh.getIndexCount(), indexSize == 2 ? "u16" : "u32", mesh.getIndexCount() * indexSize,
+					mesh.getAcmrBefore(), mesh.getAcmrAfter(), initTime * 1000.0);
+			}
+		}
+		std::printf("ACMR: vertices transformed per triangle with a 16 entries FIFO cache\n");
+		return EXIT_SUCCESS;
+	}
+
+	int benchSphereTopologies()
+	{
+		std::printf("%-11s %10s %10s %10s %14s %12s %14s\n",
+			"topology", "resolution", "triangles", "vertices", "error (radii)", "error x tris", "px at R=500");
+
+		// Resolutions giving roughly the same triangle counts for the three topologies
+		const SphereTopology topologies[] = { UVSphere, Icosphere, CubeSphere };
+		const size_t resolutions[][6] = {
+			{ 8, 16, 32, 64, 128, 256 },
+			{ 3, 5, 10, 20, 40, 81 },
+			{ 3, 7, 13, 26, 52, 105 },
+		};
+		for (int t = 0; t < 3; t++)
+		{
+			for (size_t resolution : resolutions[t])
+			{
+				Mesh mesh;
+				mesh.generate(resolution, false, topologies[t]);
+				mesh.computeStatistics();
+
+				const size_t triangles = mesh.getIndexCount() / 3;
+				const float error = mesh.getSilhouetteError();
+				std::printf("%-11s %10zu %10zu %10zu %14.3g %12.2f %14.3f\n",
+					SphereGenerator::getName(topologies[t]), resolution, triangles, mesh.getVertexCount(),
+					error, error * triangles, error * 500.0f);
+			}
+		}
+		std::printf("error: largest gap between the sphere and its mesh, the worst silhouette error from any view\n");
+		std::printf("error x tris: lower spends the triangles better, px at R=500: error of a body 500 pixels in radius\n");
+		return EXIT_SUCCESS;
+	}
+
+	int benchMeshEdits()
+	{
+		std::printf("%-18s %8s %14s %14s %14s %10s %12s\n", "edits", "ranges", "touched bytes", "upload bytes", "whole bytes", "uploaded", "copied bytes");
+
+		// A baked mesh, whose arrays are copied out of the binary on the first edit
+		size_t bakedCount = 0;
+		const size_t resolution = BakedSpheres::getResolutions(bakedCount)[bakedCount - 1];
+
+		// The clustered edits fall in kMaxRanges windows, one window in 64 of each array
+		struct Case { const char* name; size_t rangeCount, maxLength; bool clustered; };
+		const Case cases[] = { { "one range", 1, 64, false }, { "8 ranges", 8, 64, false }, { "64 in 8 clusters", 64, 16, true },
+			{ "64 ranges", 64, 16, false }, { "1000 vertices", 1000, 1, false } };
+
+		bool correct = true;
+		std::mt19937 random(3);
+		for (const Case& c : cases)
+		{
+			Mesh mesh;
+			mesh.init(resolution);
+			const size_t vertexCount = mesh.getVertexCount(), indexCount = mesh.getIndexCount();
+			const size_t indexSize = mesh.getIndexType() == GL_UNSIGNED_SHORT ? 2 : 4;
+			const size_t wholeBytes = sizeof(PackedVertex) * vertexCount + indexSize * indexCount;
+
+			// The ranges are spread over both arrays, a vertex range and an index range each time
+			FrameStats::current() = FrameStats();
+			std::vector<bool> touchedVertices(vertexCount, false), touchedIndices(indexCount, false);
+			size_t lastCopied = 0;
+			bool copiedOnce = true, editsVisible = true;
+			for (size_t range = 0; range < c.rangeCount; range++)
+			{
+				// Evenly spaced for the cases that fit in DirtyRanges, so that none is merged
+				const size_t length = 1 + random() % c.maxLength;
+				auto pickFirst = [&](size_t elementCount) {
+					if (c.rangeCount <= DirtyRanges::kMaxRanges) return range * (elementCount / c.rangeCount);
+					if (c.clustered) return (range % DirtyRanges::kMaxRanges) * (elementCount / DirtyRanges::kMaxRanges) + random() % (elementCount / 64);
+					return random() % (elementCount - length);
+				};
+				const size_t vertexFirst = pickFirst(vertexCount);
+				const size_t indexFirst = pickFirst(indexCount);
+
+				PackedVertex* vertices = mesh.editVertices(vertexFirst, length);
+				for (size_t i = 0; i < length; i++)
+				{
+					vertices[i].position.x += 1.0f;
+					touchedVertices[vertexFirst + i] = true;
+				}
+				editsVisible = editsVisible && mesh.getVertexData() + vertexFirst == vertices;
+
+				// The indices are written back unchanged, the mesh stays valid
+				unsigned char* indices = (unsigned char*)mesh.editIndices(indexFirst, length);
+				std::memmove(indices, indices, indexSize * length);
+				for (size_t i = 0; i < length; i++) touchedIndices[indexFirst + i] = true;
+
+				// Only the first edit copies the baked arrays
+				if (range > 0) copiedOnce = copiedOnce && FrameStats::current().bytesCopied == lastCopied;
+				lastCopied = FrameStats::current().bytesCopied;
+			}
+
+			const size_t touchedBytes = sizeof(PackedVertex) * std::count(touchedVertices.begin(), touchedVertices.end(), true)
+				+ indexSize * std::count(touchedIndices.begin(), touchedIndices.end(), true);
+			const size_t uploadBytes = mesh.getPendingEditBytes();
+
+			// Exactly the edited bytes while the ranges fit, a few more once the closest ones are merged, never the whole mesh
+			// The clusters are far apart, so the merges stay within them
+			const size_t clusterBytes = DirtyRanges::kMaxRanges
+				* (sizeof(PackedVertex) * (vertexCount / 64 + c.maxLength) + indexSize * (indexCount / 64 + c.maxLength));
+			const bool exact = c.rangeCount <= DirtyRanges::kMaxRanges ? uploadBytes == touchedBytes
+				: uploadBytes >= touchedBytes && (!c.clustered || uploadBytes <= clusterBytes);
+			const bool ok = exact && uploadBytes < wholeBytes && copiedOnce && editsVisible && lastCopied == wholeBytes;
+			correct = correct && ok;
+
+			std::printf("%-18s %8zu %14zu %14zu %14zu %9.2f%% %12zu %s\n", c.name, c.rangeCount, touchedBytes, uploadBytes, wholeBytes,
+				100.0 * uploadBytes / wholeBytes, lastCopied, ok ? "" : "WRONG");
+		}
+		std::printf("upload bytes: what uploadEdits() adds to FrameStats::bytesUploaded, copied bytes: the baked arrays, copied by the first edit\n");
+		std::printf(correct ? "Only the dirty ranges are uploaded\n" : "The dirty ranges do NOT match the edits\n");
+		return correct ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	int benchBakedSpheres()
+	{
+		std::printf("%-10s %10s %10s %16s %14s %10s\n", "resolution", "vertices", "indices", "generate (ms)", "baked (ms)", "identical");
+
+		size_t count = 0;
+		const size_t* resolutions = BakedSpheres::getResolutions(count);
+		bool allIdentical = true;
+		for (size_t r = 0; r < count; r++)
+		{
+			const size_t resolution = resolutions[r];
+			Mesh generated, baked;
+			const double generateTime = timeIt([&]() { generated.generate(resolution); });
+			const double bakedTime = timeIt([&]() { baked.init(resolution); });
+
+			const bool identical = generated.getVertexCount() == baked.getVertexCount()
+				&& generated.getIndexCount() == baked.getIndexCount()
+				&& generated.getIndexType() == baked.getIndexType()
+				&& std::memcmp(generated.getVertexData(), baked.getVertexData(), sizeof(PackedVertex) * baked.getVertexCount()) == 0
+				&& std::memcmp(generated.getIndexData(), baked.getIndexData(), sizeof(GLushort) * baked.getIndexCount()) == 0;
+			allIdentical = allIdentical && identical;
+
+			std::printf("%-10zu %10zu %10zu %16.3f %14.5f %10s\n", resolution, baked.getVertexCount(), baked.getIndexCount(),
+				generateTime * 1000.0, bakedTime * 1000.0, identical ? "yes" : "NO");
+		}
+		std::printf(allIdentical ? "The baked meshes are bit-identical to the generated ones\n" : "MISMATCH between the baked and generated meshes\n");
+		return allIdentical ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	int benchMeshFiles()
+	{
+		std::printf("%-22s %10s %14s %10s %12s %18s %10s\n", "mesh", "size (MB)", "generate (ms)", "save (ms)", "load (us)", "load+verify (ms)", "identical");
+
+		struct Case { size_t resolution; bool useStrips; SphereTopology topology; };
+		const Case cases[] = { { 256, false, UVSphere }, { 512, false, UVSphere }, { 1024, false, UVSphere }, { 2048, false, UVSphere },
+			{ 512, true, UVSphere }, { 64, false, Icosphere } };
+
+		const std::filesystem::path directory = std::filesystem::temp_directory_path();
+		bool allIdentical = true;
+		for (const Case& c : cases)
+		{
+			const std::string name = Mesh::getCacheFileName(c.resolution, c.useStrips, c.topology);
+			const std::string path = (directory / name).string();
+
+			Mesh generated;
+			const double generateTime = timeIt([&]() { generated.generate(c.resolution, c.useStrips, c.topology); });
+			const double saveTime = timeIt([&]() { generated.save(path); });
+
+			// Without the checksum only the header and the indices are read, the vertices are paged in by the upload
+			double loadTime = 0.0, verifyTime = 0.0;
+			bool identical = true;
+			{
+				Mesh loaded;
+				loadTime = timeIt([&]() { identical = identical && loaded.load(path, false); });
+				verifyTime = timeIt([&]() { identical = identical && loaded.load(path, true); });
+
+				const size_t indexSize = generated.getIndexType() == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+				identical = identical
+					&& loaded.getVertexCount() == generated.getVertexCount()
+					&& loaded.getIndexCount() == generated.getIndexCount()
+					&& loaded.getIndexType() == generated.getIndexType()
+					&& std::memcmp(loaded.getVertexData(), generated.getVertexData(), sizeof(PackedVertex) * generated.getVertexCount()) == 0
+					&& std::memcmp(loaded.getIndexData(), generated.getIndexData(), indexSize * generated.getIndexCount()) == 0;
+			} // Unmapped, so that Windows lets the file be removed
+			allIdentical = allIdentical && identical;
+
+			const double megabytes = std::filesystem::file_size(path) / (1024.0 * 1024.0);
+			std::printf("%-22s %10.1f %14.2f %10.2f %12.1f %18.2f %10s\n", name.c_str(), megabytes,
+				generateTime * 1000.0, saveTime * 1000.0, loadTime * 1e6, verifyTime * 1000.0, identical ? "yes" : "NO");
+
+			std::error_code error;
+			std::filesystem::remove(path, error);
+		}
+		std::printf(allIdentical ? "The loaded meshes are bit-identical to the saved ones\n" : "MISMATCH between the loaded and saved meshes\n");
+
+		// An index past the vertices must be refused with or without the checksum, or the GPU would read out of bounds
+		const std::string corruptPath = (directory / "corrupt.mesh").string();
+		Mesh source;
+		source.generate(64);
+		source.save(corruptPath);
+		std::uint64_t indexOffset = 0;
+		if (std::shared_ptr<MeshFile> file = MeshFile::open(corruptPath)) indexOffset = file->getHeader().indexOffset;
+		{
+			std::fstream stream(corruptPath, std::ios::in | std::ios::out | std::ios::binary);
+			stream.seekp((std::streamoff)indexOffset);
+			const char corruptIndex[4] = { '\xff', '\xff', '\xff', '\x7f' };
+			stream.write(corruptIndex, sizeof(corruptIndex));
+		}
+		const bool corruptionRefused = indexOffset != 0 && !MeshFile::open(corruptPath, false) && !MeshFile::open(corruptPath, true);
+		std::printf(corruptionRefused ? "An out of range index is refused with and without the checksum\n" : "An out of range index is NOT refused\n");
+		std::error_code error;
+		std::filesystem::remove(corruptPath, error);
+
+		return allIdentical && corruptionRefused ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	int benchMeshArena()
+	{
+		std::printf("%-32s %10s %12s %14s %10s\n", "mesh", "vertices", "arena (KB)", "heap blocks", "aligned");
+
+		struct Case { size_t resolution; bool useStrips; SphereTopology topology; };
+		const Case cases[] = { { 16, false, UVSphere }, { 512, false, UVSphere }, { 512, true, UVSphere },
+			{ 32, false, Icosphere }, { 32, true, CubeSphere } };
+
+		bool allPacked = true;
+		for (const Case& c : cases)
+		{
+			Mesh mesh;
+			mesh.generate(c.resolution, c.useStrips, c.topology);
+			const bool aligned = (std::uintptr_t)mesh.getVertexData() % Arena::kAlignment == 0 && (std::uintptr_t)mesh.getIndexData() % Arena::kAlignment == 0;
+			const size_t blocks = mesh.getArena().getBlockCount();
+			allPacked = allPacked && aligned && blocks == 1;
+
+			const std::string name = Mesh::getCacheFileName(c.resolution, c.useStrips, c.topology);
+			std::printf("%-32s %10zu %12.1f %14zu %10s\n", name.c_str(), mesh.getVertexCount(), mesh.getArena().getBytesUsed() / 1024.0,
+				blocks, aligned ? "yes" : "NO");
+		}
+
+		// Generating again reuses the block, and destroying a mesh frees it in one step
+		const size_t meshCount = 10000;
+		const double buildTime = timeIt([&]() {
+			std::vector<Mesh> meshes(meshCount);
+			for (Mesh& mesh : meshes) mesh.generate(16);
+		});
+		std::printf("%zu meshes of resolution 16 built and freed in %.2f ms, %.2f us each\n", meshCount, buildTime * 1000.0, buildTime * 1e6 / meshCount);
+
+		std::printf(allPacked ? "Every mesh is in a single aligned heap block\n" : "Some meshes are NOT in a single aligned heap block\n");
+		return allPacked ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	int benchEphemeris()
+	{
+		const double pi = 3.14159265358979323846;
+
+		// The orbit of the Earth in the solar system: a circle of radius 10 done in about 26 seconds, ticked 60 times per second
+		const double radius = 10.0, period = 2.0 * pi * 500.0 / 120.0, tick = 1.0 / 60.0;
+		OrbitalElements orbit;
+		orbit.semiMajorAxis = radius;
+		orbit.period = period;
+		Ephemeris ephemeris;
+		ephemeris.addBody(orbit, SpinElements());
+
+		// The former update(): a small rotation of the model matrix around the sun at every tick, in floats, the error adding up
+		glm::vec3 accumulated((float)radius, 0.0f, 0.0f);
+		auto rotateAroundSun = [&accumulated](double angle) {
+			const glm::mat4 rotation = MeshUtility::rotateAroundAxis(Y_ROTATION_VECTOR, (float)angle);
+			accumulated = glm::vec3(rotation * glm::vec4(accumulated, 1.0f));
+		};
+
+		std::printf("%-8s %10s %20s %20s\n", "hours", "ticks", "accumulated error", "accumulated radius");
+		size_t ticks = 0;
+		const double hours[] = { 1.0, 4.0, 24.0 };
+		for (double hour : hours)
+		{
+			for (; ticks < (size_t)(hour * 3600.0 / tick); ticks++)
+			{
+				rotateAroundSun(2.0 * pi * tick / period);
+			}
+			const glm::dvec3 exact = ephemeris.computePosition(0, ticks * tick);
+			std::printf("%-8.0f %10zu %20.6f %20.6f\n", hour, ticks, glm::length(glm::dvec3(accumulated) - exact),
+				glm::length(glm::dvec3(accumulated)));
+		}
+
+		// Solving Kepler's equation for the whole range of mean anomalies
+		double maxResidual = 0.0;
+		const double eccentricities[] = { 0.0, 0.2, 0.5, 0.9, 0.99 };
+		for (double e : eccentricities)
+		{
+			for (int i = 0; i <= 10000; i++)
+			{
+				const double meanAnomaly = -pi + 2.0 * pi * i / 10000;
+				const double eccentricAnomaly = Ephemeris::solveKepler(meanAnomaly, e);
+				maxResidual = std::max(maxResidual, std::abs(eccentricAnomaly - e * std::sin(eccentricAnomaly) - meanAnomaly));
+			}
+		}
+		std::printf("Largest residual of Kepler's equation, eccentricities up to 0.99: %.3g\n", maxResidual);
+
+		// An eccentric, inclined orbit comes back to the same place every period, even a million periods away
+		orbit.eccentricity = 0.25;
+		orbit.inclination = 0.3;
+		orbit.ascendingNode = 1.9;
+		orbit.argumentOfPeriapsis = 2.0;
+		orbit.meanAnomalyAtEpoch = 0.7;
+		const double farTime = 1e6 * period + 3.0;
+		const double periodError = glm::length(Ephemeris::computeOrbitPosition(orbit, farTime) - Ephemeris::computeOrbitPosition(orbit, 3.0));
+		std::printf("Position error a million periods later: %.3g\n", periodError);
+
+		// Seeking to any date costs the same, each body is placed on its own
+		const size_t bodyCount = 10;
+		Ephemeris solarSystem;
+		for (size_t i = 0; i < bodyCount; i++)
+		{
+			orbit.semiMajorAxis = 5.0 + 30.0 * i;
+			orbit.period = period * (1.0 + i);
+			solarSystem.addBody(orbit, SpinElements{ period, 0.4, 0.0 });
+		}
+		volatile double sink = 0.0; // Keeps the placements from being optimized away
+		const double seekTime = timeIt([&]() {
+			for (size_t i = 0; i < bodyCount; i++) sink = solarSystem.computePosition(i, farTime).x + solarSystem.computeOrientation(i, farTime)[0][0];
+		});
+		std::printf("Placing %zu bodies at any date: %.2f us, %.0f ns per body\n", bodyCount, seekTime * 1e6, seekTime * 1e9 / bodyCount);
+
+		const bool accurate = maxResidual < 1e-12 && periodError < 1e-6;
+		std::printf(accurate ? "The ephemeris is accurate\n" : "The ephemeris is NOT accurate\n");
+		return accurate ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	int benchFixedTimestep()
+	{
+		// A float clock loses the milliseconds after a few hours of uptime, a double one keeps them for centuries
+		std::printf("%-12s %18s %18s\n", "uptime (h)", "float step (ms)", "double step (ns)");
+		const double uptimes[] = { 1.0, 4.0, 24.0, 24.0 * 30.0 };
+		for (double hours : uptimes)
+		{
+			const float floatTime = (float)(hours * 3600.0);
+			const double doubleTime = hours * 3600.0;
+			std::printf("%-12.0f %18.3f %18.6f\n", hours, (std::nextafter(floatTime, 2.0f * floatTime) - floatTime) * 1000.0,
+				(std::nextafter(doubleTime, 2.0 * doubleTime) - doubleTime) * 1e9);
+		}
+
+		// Frame timings of a minute, the simulation must follow the clock with any of them, a step behind at most
+		struct Case { const char* name; double interval; double jitter; double stall; };
+		const Case cases[] = { { "60 Hz", 1.0 / 60.0, 0.0, 0.0 }, { "144 Hz", 1.0 / 144.0, 0.0, 0.0 }, { "30 Hz", 1.0 / 30.0, 0.0, 0.0 },
+			{ "jittery 25-75 Hz", 1.0 / 50.0, 0.5, 0.0 }, { "60 Hz, 2 s stall", 1.0 / 60.0, 0.0, 2.0 } };
+
+		const double step = 1.0 / 60.0, duration = 60.0;
+		const size_t maxSteps = 8;
+		std::printf("%-18s %10s %12s %16s %14s %12s\n", "frame timing", "frames", "steps", "steps per frame", "dropped (s)", "error (ns)");
+
+		bool allFollow = true;
+		std::srand(1);
+		for (const Case& c : cases)
+		{
+			// Starting after hours of uptime, as on the kiosks
+			FixedTimestep clock(step, maxSteps);
+			const double start = 8.0 * 3600.0;
+			double now = start;
+			size_t frames = 0, steps = 0, mostSteps = 0;
+			clock.advance(now);
+			while (now - start < duration)
+			{
+				double interval = c.interval * (1.0 + c.jitter * (2.0 * std::rand() / RAND_MAX - 1.0));
+				if (c.stall > 0.0 && frames == 600) interval = c.stall;
+				now += interval;
+
+				const size_t frameSteps = clock.advance(now);
+				steps += frameSteps;
+				mostSteps = std::max(mostSteps, frameSteps);
+				frames++;
+			}
+
+			// The simulated time, with the part of a step the drawing is interpolated by, is the elapsed time but for the dropped one
+			const double simulated = (steps + clock.getAlpha()) * step;
+			const double error = std::abs(simulated - (now - start - clock.getDroppedTime()));
+			const bool follows = error < 1e-6 && mostSteps <= maxSteps;
+			allFollow = allFollow && follows;
+			std::printf("%-18s %10zu %12zu %16zu %14.3f %12.3f\n", c.name, frames, steps, mostSteps, clock.getDroppedTime(), error * 1e9);
+		}
+		std::printf(allFollow ? "The simulation follows the clock at every frame rate\n" : "The simulation does NOT follow the clock\n");
+		return allFollow ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	// Bodies of a Plummer cluster of radius 1 and total mass 1, the same for a given count
+	void plummerCluster(size_t count, std::vector<glm::dvec3>& positions, std::vector<double>& masses)
+	{
+		std::mt19937_64 random(42);
+		std::uniform_real_distribution<double> uniform(0.0, 1.0);
+		positions.resize(count);
+		masses.assign(count, 1.0 / count);
+		for (glm::dvec3& position : positions)
+		{
+			// The radius from the inverse of the cumulated mass, cut at 10, in a random direction
+			const double radius = std::min(1.0 / std::sqrt(std::pow(std::max(uniform(random), 1e-6), -2.0 / 3.0) - 1.0), 10.0);
+			const double z = 2.0 * uniform(random) - 1.0, phi = 2.0 * 3.14159265358979323846 * uniform(random);
+			position = radius * glm::dvec3(std::sqrt(1.0 - z * z) * std::cos(phi), std::sqrt(1.0 - z * z) * std::sin(phi), z);
+		}
+	}
+
+	// Relative error of the accelerations of a few bodies against the exact sum over all the others
+	double barnesHutError(const std::vector<glm::dvec3>& positions, const std::vector<double>& masses,
+		const std::vector<glm::dvec3>& accelerations, double softening)
+	{
+		const size_t samples = 64;
+		double squaredError = 0.0;
+		for (size_t sample = 0; sample < samples; sample++)
+		{
+			const size_t body = sample * positions.size() / samples;
+			glm::dvec3 exact(0.0);
+			for (size_t other = 0; other < positions.size(); other++)
+			{
+				if (other == body) continue;
+				const glm::dvec3 offset = positions[other] - positions[body];
+				const double inverseDistance = 1.0 / std::sqrt(glm::dot(offset, offset) + softening * softening);
+				exact += (masses[other] * inverseDistance * inverseDistance * inverseDistance) * offset;
+			}
+			const double error = glm::length(accelerations[body] - exact) / glm::length(exact);
+			squaredError += error * error;
+		}
+		return std::sqrt(squaredError / samples);
+	}
+
+	int benchBarnesHut()
+	{
+		const double softening = 0.01;
+		const size_t hardwareThreads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+		ThreadPool threadPool(hardwareThreads);
+		auto timeOnce = [](auto function) {
+			const Clock::time_point start = Clock::now();
+			function();
+			return std::chrono::duration<double>(Clock::now() - start).count();
+		};
+
+		std::printf("%zu workers, opening angle 0.5\n", hardwareThreads);
+		std::printf("%-10s %10s %12s %12s %16s %18s %12s %12s\n", "bodies", "nodes", "build (ms)", "forces (ms)", "interactions", "interactions/s", "rms error", "identical");
+
+		bool allIdentical = true;
+		const size_t counts[] = { 1000, 10000, 100000, 1000000 };
+		std::vector<glm::dvec3> positions, accelerations, reference;
+		std::vector<double> masses;
+		for (size_t count : counts)
+		{
+			plummerCluster(count, positions, masses);
+			accelerations.resize(count);
+
+			BarnesHut solver(&threadPool);
+			solver.setSoftening(softening);
+			size_t interactions = 0;
+			const double buildTime = timeOnce([&]() { solver.build(positions.data(), masses.data(), count); });
+			const double forceTime = timeOnce([&]() { interactions = solver.computeAccelerations(accelerations.data()); });
+
+			// The same bodies on the calling thread, and on a single worker, give the same bits
+			bool identical = true;
+			if (count <= 100000)
+			{
+				ThreadPool singleThread(1);
+				BarnesHut serial(nullptr), single(&singleThread);
+				for (BarnesHut* other : { &serial, &single })
+				{
+					other->setSoftening(softening);
+					other->build(positions.data(), masses.data(), count);
+					reference.resize(count);
+					other->computeAccelerations(reference.data());
+					identical = identical && std::memcmp(reference.data(), accelerations.data(), sizeof(glm::dvec3) * count) == 0;
+				}
+				allIdentical = allIdentical && identical;
+			}
+
+			std::printf("%-10zu %10zu %12.1f %12.1f %16zu %18.3g %12.2e %12s\n", count, solver.getNodeCount(), buildTime * 1000.0, forceTime * 1000.0,
+				interactions, interactions / forceTime, barnesHutError(positions, masses, accelerations, softening), count <= 100000 ? (identical ? "yes" : "NO") : "-");
+		}
+
+		// The opening angle trades accuracy for speed
+		const size_t count = 100000;
+		plummerCluster(count, positions, masses);
+		accelerations.resize(count);
+		std::printf("%-14s %12s %18s %12s\n", "opening angle", "forces (ms)", "interactions/body", "rms error");
+		const double openingAngles[] = { 0.3, 0.5, 0.7, 1.0 };
+		for (double openingAngle : openingAngles)
+		{
+			BarnesHut solver(&threadPool);
+			solver.setSoftening(softening);
+			solver.setOpeningAngle(openingAngle);
+			solver.build(positions.data(), masses.data(), count);
+			size_t interactions = 0;
+			const double forceTime = timeOnce([&]() { interactions = solver.computeAccelerations(accelerations.data()); });
+			std::printf("%-14.1f %12.1f %18.0f %12.2e\n", openingAngle, forceTime * 1000.0, (double)interactions / count,
+				barnesHutError(positions, masses, accelerations, softening));
+		}
+
+		std::printf(allIdentical ? "The accelerations are bit-identical with any amount of workers\n" : "The accelerations DIFFER with the amount of workers\n");
+		return allIdentical ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	int benchKeplerKernel()
+	{
+		const double pi = 3.14159265358979323846;
+		const size_t count = 1 << 20;
+		std::mt19937_64 random(7);
+		std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+		// The eccentricities by band, against the double precision Newton solver of the ephemeris
+		// A few float ulps of pi up to 0.99, the fixed iterations being enough for the worst band
+		struct Band { double low, high, maxError; };
+		const Band bands[] = { { 0.0, 0.3, 2e-6 }, { 0.3, 0.6, 2e-6 }, { 0.6, 0.9, 2e-6 }, { 0.9, 0.99, 2e-6 } };
+		std::printf("%-12s %12s", "eccentricity", "reference");
+		for (int impl = KeplerKernel::Scalar; impl <= KeplerKernel::AVX2; impl++)
+			std::printf(" %22s", KeplerKernel::getName((KeplerKernel::Implementation)impl));
+		std::printf("\n%-12s %12s", "", "(Msolves/s)");
+		for (int impl = KeplerKernel::Scalar; impl <= KeplerKernel::AVX2; impl++) std::printf(" %22s", "Msolves/s, max error");
+		std::printf("\n");
+
+		bool accurate = true;
+		std::vector<float> meanAnomaly(count), eccentricity(count), eccentricAnomaly(count);
+		std::vector<double> reference(count);
+		for (const Band& band : bands)
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				meanAnomaly[i] = (float)(pi * (2.0 * uniform(random) - 1.0));
+				eccentricity[i] = (float)(band.low + (band.high - band.low) * uniform(random));
+			}
+
+			const double referenceTime = timeIt([&]() {
+				for (size_t i = 0; i < count; i++) reference[i] = Ephemeris::solveKepler(meanAnomaly[i], eccentricity[i]);
+			});
+			std::printf("%4.2f - %4.2f  %12.1f", band.low, band.high, count / referenceTime / 1e6);
+
+			for (int impl = KeplerKernel::Scalar; impl <= KeplerKernel::AVX2; impl++)
+			{
+				const KeplerKernel::Implementation implementation = (KeplerKernel::Implementation)impl;
+				if (!KeplerKernel::isSupported(implementation))
+				{
+					std::printf(" %22s", "n/a");
+					continue;
+				}
+
+				const double time = timeIt([&]() {
+					KeplerKernel::solve(implementation, meanAnomaly.data(), eccentricity.data(), eccentricAnomaly.data(), count);
+				});
+				double maxError = 0.0;
+				for (size_t i = 0; i < count; i++) maxError = std::max(maxError, std::abs(eccentricAnomaly[i] - reference[i]));
+				std::printf(" %10.1f (x%3.0f) %7.1e", count / time / 1e6, referenceTime / time, maxError);
+
+				accurate = accurate && maxError < band.maxError;
+			}
+			std::printf("\n");
+		}
+
+		// Whole positions of a belt, against the ephemeris placing them one by one in double precision
+		KeplerOrbitsSoA orbits;
+		orbits.resize(count);
+		std::vector<OrbitalElements> elements(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			OrbitalElements& orbit = elements[i];
+			orbit.semiMajorAxis = 20.0 + 25.0 * uniform(random);
+			orbit.eccentricity = 0.3 * uniform(random);
+			orbit.inclination = 0.3 * uniform(random);
+			orbit.ascendingNode = 2.0 * pi * uniform(random);
+			orbit.argumentOfPeriapsis = 2.0 * pi * uniform(random);
+			orbit.meanAnomalyAtEpoch = 2.0 * pi * uniform(random);
+			orbit.period = 26.18 * std::pow(orbit.semiMajorAxis / 10.0, 1.5);
+			orbits.set(i, orbit);
+		}
+
+		const double time = 1000.0;
+		orbits.rebase(time);
+		const double referenceTime = timeIt([&]() {
+			for (size_t i = 0; i < count; i += 64) reference[i] = Ephemeris::computeOrbitPosition(elements[i], time).x;
+		}) * 64.0;
+		std::printf("%zu positions: reference %.1f M/s", count, count / referenceTime / 1e6);
+
+		VertexSoA positions;
+		positions.resize(count);
+		for (int impl = KeplerKernel::Scalar; impl <= KeplerKernel::AVX2; impl++)
+		{
+			const KeplerKernel::Implementation implementation = (KeplerKernel::Implementation)impl;
+			if (!KeplerKernel::isSupported(implementation)) continue;
+
+			const double kernelTime = timeIt([&]() {
+				KeplerKernel::computePositions(implementation, orbits, time, glm::vec3(0.0f), positions, 0, count);
+			});
+			double maxError = 0.0;
+			for (size_t i = 0; i < count; i += 64)
+			{
+				maxError = std::max(maxError, glm::length(glm::dvec3(positions.get(i)) - Ephemeris::computeOrbitPosition(elements[i], time)));
+			}
+			std::printf(", %s %.1f M/s (max error %.1e)", KeplerKernel::getName(implementation), count / kernelTime / 1e6, maxError);
+			accurate = accurate && maxError < 1e-3;
+		}
+		std::printf("\n");
+
+		std::printf(accurate ? "The kernels match the reference solver: 2e-6 rad up to e = 0.99, 1e-3 for the positions\n"
+			: "The kernels do NOT match the reference solver\n");
+		return accurate ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	int benchParticleSystem()
+	{
+		const double pi = 3.14159265358979323846;
+		const double secondsPerYear = 26.18;
+		const size_t count = 1000000;
+
+		// A main belt and a Kuiper belt, as drawn by the application
+		std::mt19937 random(2);
+		std::uniform_real_distribution<double> uniform(0.0, 1.0);
+		std::vector<OrbitalElements> elements(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			const bool kuiper = i >= count * 6 / 10;
+			OrbitalElements& orbit = elements[i];
+			orbit.semiMajorAxis = kuiper ? 300.0 + 180.0 * uniform(random) : 21.0 + 12.0 * uniform(random);
+			orbit.eccentricity = (kuiper ? 0.2 : 0.25) * uniform(random);
+			orbit.inclination = (kuiper ? 0.5 : 0.35) * uniform(random) * uniform(random);
+			orbit.ascendingNode = 2.0 * pi * uniform(random);
+			orbit.argumentOfPeriapsis = 2.0 * pi * uniform(random);
+			orbit.meanAnomalyAtEpoch = 2.0 * pi * uniform(random);
+			orbit.period = secondsPerYear * std::pow(orbit.semiMajorAxis / 10.0, 1.5);
+		}
+		auto build = [&](ParticleSystem& particles) {
+			for (const OrbitalElements& orbit : elements) particles.addOrbitingParticle(orbit, 0.02f, glm::vec4(1.0f));
+		};
+
+		std::vector<size_t> threadCounts;
+		const size_t hardwareThreads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+		for (size_t threads = 1; threads < hardwareThreads; threads *= 2) threadCounts.push_back(threads);
+		threadCounts.push_back(hardwareThreads);
+
+		std::printf("%-8s %12s %16s %14s %10s\n", "threads", "update (ms)", "Mparticles/s", "frame at 60Hz", "identical");
+
+		// Placed on the calling thread, for reference
+		const double time = 100.0;
+		const glm::vec3 focus(0.0f);
+		ParticleSystem serial;
+		const Clock::time_point buildStart = Clock::now();
+		build(serial);
+		const double buildTime = std::chrono::duration<double>(Clock::now() - buildStart).count();
+		// What update() streams, without the GL: one array per coordinate, padded for the kernel
+		struct Positions
+		{
+			std::vector<float> x, y, z;
+			explicit Positions(size_t size) : x(size), y(size), z(size) {}
+			glm::dvec3 get(size_t i) const { return glm::dvec3(x[i], y[i], z[i]); }
+		};
+		Positions serialPositions(serial.getPaddedOrbitingCount());
+		auto place = [](ParticleSystem& particles, Positions& positions, double at, const glm::vec3& center) {
+			particles.computePositions(at, center, positions.x.data(), positions.y.data(), positions.z.data());
+		};
+		const double serialTime = timeIt([&]() { place(serial, serialPositions, time, focus); }, 1.0);
+		std::printf("%-8s %12.2f %16.1f %13.0f%% %10s\n", "none", serialTime * 1000.0, count / serialTime / 1e6, serialTime * 6000.0, "");
+
+		bool allIdentical = true;
+		for (size_t threads : threadCounts)
+		{
+			ThreadPool threadPool(threads);
+			ParticleSystem parallel(&threadPool);
+			build(parallel);
+			Positions parallelPositions(parallel.getPaddedOrbitingCount());
+			const double updateTime = timeIt([&]() { place(parallel, parallelPositions, time, focus); }, 1.0);
+
+			const size_t bytes = sizeof(float) * count;
+			const bool identical = std::memcmp(parallelPositions.x.data(), serialPositions.x.data(), bytes) == 0
+				&& std::memcmp(parallelPositions.y.data(), serialPositions.y.data(), bytes) == 0
+				&& std::memcmp(parallelPositions.z.data(), serialPositions.z.data(), bytes) == 0;
+			allIdentical = allIdentical && identical;
+			std::printf("%-8zu %12.2f %16.1f %13.0f%% %10s\n",
+				threads, updateTime * 1000.0, count / updateTime / 1e6, updateTime * 6000.0, identical ? "yes" : "NO");
+		}
+
+		std::printf("%zu particles built in %.0f ms, %.1f MB streamed per frame\n", count, buildTime * 1000.0, 3.0 * sizeof(float) * count / 1e6);
+
+		// Far from the first epoch the orbits are rebased from their double elements, the error does not grow with time
+		bool accurate = true;
+		const double times[] = { time, 1e4, 1e5, 1e6, 1e7 };
+		for (double at : times)
+		{
+			place(serial, serialPositions, at, focus);
+			double maxError = 0.0;
+			for (size_t i = 0; i < count; i += 64)
+			{
+				maxError = std::max(maxError, glm::length(serialPositions.get(i) - Ephemeris::computeOrbitPosition(elements[i], at)));
+			}
+			std::printf("max error against the ephemeris at %.0e s: %.1e\n", at, maxError);
+			accurate = accurate && maxError < 1e-2;
+		}
+
+		return allIdentical && accurate ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	int benchParallelGeneration()
+	{
+		std::printf("%-10s %8s %12s %12s %14s %9s %11s %10s\n",
+			"resolution", "threads", "vertices", "time (ms)", "Mvertices/s", "speedup", "efficiency", "identical");
+
+		// The thread counts double up to the amount of hardware threads
+		std::vector<size_t> threadCounts;
+		const size_t hardwareThreads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+		for (size_t threads = 1; threads < hardwareThreads; threads *= 2) threadCounts.push_back(threads);
+		threadCounts.push_back(hardwareThreads);
+
+		bool allIdentical = true;
+		const size_t resolutions[] = { 2048, 4096 };
+		for (size_t resolution : resolutions)
+		{
+			// Generated on the calling thread, for reference
+			Mesh serial;
+			const double serialTime = timeIt([&]() { serial.generate(resolution); }, 1.0);
+			const size_t vertices = serial.getVertexCount();
+			std::printf("%-10zu %8s %12zu %12.1f %14.1f %9s %11s %10s\n",
+				resolution, "none", vertices, serialTime * 1000.0, vertices / serialTime / 1e6, "", "", "");
+
+			double singleThreadTime = 0.0;
+			for (size_t threads : threadCounts)
+			{
+				ThreadPool threadPool(threads);
+				Mesh parallel;
+				const double time = timeIt([&]() { parallel.generate(resolution, false, UVSphere, &threadPool); }, 1.0);
+				if (threads == 1) singleThreadTime = time;
+
+				const bool identical = parallel.getIndexType() == serial.getIndexType()
+					&& std::memcmp(parallel.getVertexData(), serial.getVertexData(), sizeof(PackedVertex) * vertices) == 0
+					&& std::memcmp(parallel.getIndexData(), serial.getIndexData(), (serial.getIndexType() == GL_UNSIGNED_SHORT ? 2 : 4) * serial.getIndexCount()) == 0;
+				allIdentical = allIdentical && identical;
+
+				const double speedup = singleThreadTime / time;
+				std::printf("%-10zu %8zu %12zu %12.1f %14.1f %8.2fx %10.0f%% %10s\n",
+					resolution, threads, vertices, time * 1000.0, vertices / time / 1e6, speedup, 100.0 * speedup / threads, identical ? "yes" : "NO");
+			}
+		}
+		std::printf("Vertices and triangles of the UV sphere list, speedup and efficiency against 1 worker\n");
+		return allIdentical ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	struct BenchmarkEntry
+	{
+		const char* name;
+		const char* description;
+		int (*function)();
+	};
+
+	const BenchmarkEntry benchmarks[] = {
+		{ "vertex", "SoA SIMD vertex kernel against the former per-vertex AoS loop", benchVertexKernel },
+		{ "indices", "Index type, size and vertex cache efficiency of the generated spheres", benchSphereIndices },
+		{ "edits", "Checks editing scattered ranges of a mesh only uploads the dirty ranges, and copies a baked mesh once", benchMeshEdits },
+		{ "baked", "Checks the spheres baked at build time are bit-identical to the generated ones, and times both", benchBakedSpheres },
+		{ "arena", "Checks every mesh is stored in a single aligned block, and times building and freeing many of them", benchMeshArena },
+		{ "meshfile", "Saves meshes to mesh files and times their memory-mapped loading, with and without the checksum", benchMeshFiles },
+		{ "ephemeris", "Drift of the former per-tick rotations against the ephemeris, accuracy of the Kepler solver and cost of a seek", benchEphemeris },
+		{ "timestep", "Checks the fixed-step simulation follows the clock at various frame rates, and the precision of float and double clocks", benchFixedTimestep },
+		{ "nbody", "Interactions per second of the Barnes-Hut gravity from 1k to 1M bodies, its accuracy and determinism", benchBarnesHut },
+		{ "kepler", "Precision and throughput of the SIMD batch Kepler solver against the scalar double precision one", benchKeplerKernel },
+		{ "particles", "Time to place a million belt particles on the workers, against the ephemeris and the serial placement", benchParticleSystem },
+		{ "generation", "Vertices per second of the UV sphere generation by amount of worker threads", benchParallelGeneration },
+		{ "topology", "Triangle count against silhouette error of the UV sphere, icosphere and cube-sphere", benchSphereTopologies },
+	};
+}
+
+int runBenchmark(const std::string& name)
+{
+	for (const BenchmarkEntry& entry : benchmarks)
+	{
+		if (name == entry.name) return entry.function();
+	}
+
+	if (name != "list") std::cerr << "Unknown benchmark: " << name << std::endl;
+	std::cout << "Available benchmarks:" << std::endl;
+	for (const BenchmarkEntry& entry : benchmarks)
+	{
+		std::cout << "  " << entry.name << "\t" << entry.description << std::endl;
+	}
+	return name == "list" ? EXIT_SUCCESS : EXIT_FAILURE;
+}
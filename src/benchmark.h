@@ -0,0 +1,17 @@
+#ifndef INCLUDE_BENCHMARK
+#define INCLUDE_BENCHMARK
+
+#include <string>
+
+/*
+* @brief Runs one of the CPU micro-benchmarks and prints its results, without opening any window.
+*
+* Started with `tpOpenGL --bench <name>`, `tpOpenGL --bench list` prints the available names.
+*
+* @param name The name of the benchmark to run.
+*
+* @return The exit code of the program.
+*/
+int runBenchmark(const std::string& name);
+
+#endif
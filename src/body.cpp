@@ -0,0 +1,47 @@
+#include "body.h"
+
+#include <utility>
+
+Body::Body(std::shared_ptr<SphereLods> lods) :
+	m_lods(std::move(lods))
+{
+}
+
+void Body::setupSun()
+{
+	m_emissive = true;
+}
+
+void Body::move(glm::mat4 matxMove)
+{
+	transform(matxMove);
+}
+
+void Body::place(const glm::vec3& center, const glm::mat3& orientation, bool continuous)
+{
+	const glm::quat placedOrientation = glm::quat_cast(orientation);
+	m_previousCenter = continuous && m_placed ? m_placedCenter : center;
+	m_previousOrientation = continuous && m_placed ? m_placedOrientation : placedOrientation;
+	m_placedCenter = center;
+	m_placedOrientation = placedOrientation;
+	m_placed = true;
+
+	interpolate(1.0f);
+}
+
+void Body::interpolate(float alpha)
+{
+	// The poles of the sphere meshes are on Z, turned onto the spin axis Y
+	const float radius = getRadius();
+	m_selfCenter = glm::mix(m_previousCenter, m_placedCenter, alpha);
+	m_modelMatrix = MeshUtility::translate(m_selfCenter) *
+		glm::mat4_cast(glm::slerp(m_previousOrientation, m_placedOrientation, alpha)) *
+		MeshUtility::rotateAroundAxis(X_ROTATION_VECTOR, (float)-M_PI / 2) *
+		glm::scale(glm::mat4(1.0f), glm::vec3(radius));
+}
+
+void Body::transform(glm::mat4 matxTrans)
+{
+	m_selfCenter = glm::vec3(matxTrans * glm::vec4{ m_selfCenter, 1 });
+	m_modelMatrix = matxTrans * m_modelMatrix;
+}
@@ -0,0 +1,143 @@
+#ifndef INCLUDE_BODY
+#define INCLUDE_BODY
+
+#include "mesh.h"
+#include "meshUtility.h"
+#include "sphereLods.h"
+
+#include <dep/glm/glm.hpp>
+#include <dep/glm/gtc/quaternion.hpp>
+
+#include <memory>
+
+/*
+* @brief A celestial body: a reference to shared sphere meshes plus the few values placing it in the world.
+*/
+class Body
+{
+public:
+	/*
+	* @brief Creates a body at the origin of the world.
+	* 
+	* @param lods The levels of detail of the sphere the body is drawn with, shared with the other bodies.
+	*/
+	explicit Body(std::shared_ptr<SphereLods> lods);
+
+	/*
+	* @brief Sets up the sun-specific parameters.
+	*/
+	void setupSun();
+
+	/*
+	* @brief Move a body linearly.
+	* 
+	* @param matxMove The transformation matrix describing how to move the body
+	*/
+	void move(glm::mat4 matxMove);
+
+	/*
+	* @brief Puts the body at a given place and orientation, e.g. from an Ephemeris, keeping its radius.
+	* 
+	* The previous placement is kept for interpolate(), unless the body jumps.
+	* 
+	* @param center The coordinates of the center of the body.
+	* @param orientation The rotation from the frame of the body, its spin axis being Y, to the world.
+	* @param continuous Whether the body moved there since the last placement, false when it jumps.
+	*/
+	void place(const glm::vec3& center, const glm::mat3& orientation, bool continuous = true);
+
+	/*
+	* @brief Moves the body between its last two placements, to draw it between two simulation steps.
+	* 
+	* @param alpha 0 for the previous placement, 1 for the last one.
+	*/
+	void interpolate(float alpha);
+
+	/*
+	* @brief Get the center of the body.
+	* 
+	* @return The coordinate of the center of the body.
+	*/
+	inline glm::vec3 getSelfCenter() const { return m_selfCenter; }
+
+	/*
+	* @brief Get the matrix placing the local-space geometry in the world.
+	* 
+	* @return The model matrix of the body, to be sent to vertexShader.glsl.
+	*/
+	inline const glm::mat4& getModelMatrix() const { return m_modelMatrix; }
+
+	/*
+	* @brief Select the texture of the body.
+	* 
+	* @param layer The layer of the body texture array holding the body's texture.
+	*/
+	inline void setTextureLayer(int layer) { m_textureLayer = layer; }
+
+	/*
+	* @brief Get the per-instance data describing the body to vertexShader.glsl.
+	* 
+	* @return The instance to send to the Mesh of the body.
+	*/
+	inline MeshInstance getInstance() const
+	{
+		return MeshInstance{ m_modelMatrix, (float)m_textureLayer, m_emissive ? 1.0f : 0.0f };
+	}
+
+	/*
+	* @brief Get the radius of the body, the scale of its model matrix.
+	*/
+	inline float getRadius() const { return glm::length(glm::vec3(m_modelMatrix[0])); }
+
+	/*
+	* @brief Get the levels of detail the body is drawn with.
+	*/
+	inline const std::shared_ptr<SphereLods>& getLods() const { return m_lods; }
+
+	/*
+	* @brief Picks the level of detail to draw the body with this frame, and remembers it for the next one.
+	* 
+	* @param projectedRadius The radius of the body on screen, in pixels.
+	* 
+	* @return The level of getLods() to draw the body with.
+	*/
+	inline int updateLodLevel(float projectedRadius)
+	{
+		m_lodLevel = m_lods->selectLevel(projectedRadius, m_lodLevel);
+		return m_lodLevel;
+	}
+
+	inline int getLodLevel() const { return m_lodLevel; }
+
+private:
+	std::shared_ptr<SphereLods> m_lods;
+
+	// Level of detail drawn last frame, negative before the first one
+	int m_lodLevel = -1;
+
+	// Local to world transformation, accumulated by transform()
+	glm::mat4 m_modelMatrix{ glm::mat4(1.0f) };
+
+	glm::vec3 m_selfCenter{ glm::vec3(0.0f) };
+
+	int m_textureLayer = 0;
+
+	// Whether the body emits its own light, regardless of the sun
+	bool m_emissive = false;
+
+	// The last two calls to place(), the orientations as quaternions to be interpolated
+	bool m_placed = false;
+	glm::vec3 m_previousCenter{ glm::vec3(0.0f) }, m_placedCenter{ glm::vec3(0.0f) };
+	glm::quat m_previousOrientation{ glm::quat(1.0f, 0.0f, 0.0f, 0.0f) }, m_placedOrientation{ glm::quat(1.0f, 0.0f, 0.0f, 0.0f) };
+
+	/*
+	* @brief A general purpose function for applying (or creating) a transformation matrix.
+	* 
+	* This function serves to either apply a translation matrix, or apply a rotation matrix around an axis.
+	* Only the model matrix is updated, the shared vertices stay untouched.
+	* 
+	* @param matxTrans The transformation matrix describing how to move the body
+	*/
+	void transform(glm::mat4 matxTrans);
+};
+#endif
@@ -14,7 +14,7 @@ public:
 	inline void setNear(const float n) { m_near = n; }
 	inline float getFar() const { return m_far; }
 	inline void setFar(const float n) { m_far = n; }
-	inline glm::vec3 getPosition() { return m_pos; }
+	inline glm::vec3 getPosition() const { return m_pos; }
 	inline void setPosition(const glm::vec3& p) { m_pos = p; }
 	inline glm::vec3 getCenter() const { return m_center; }
 	inline void setCenter(const glm::vec3 c) { m_center = c; }
@@ -28,6 +28,16 @@ public:
 		return glm::perspective(glm::radians(m_fov), m_aspectRatio, m_near, m_far);
 	}
 
+	// Returns the size, in pixels, of a length seen face-on at some distance from the camera.
+	inline float computeProjectedSize(float size, float distance, float viewportHeight) const {
+		return size / distance * 0.5f * viewportHeight / glm::tan(0.5f * glm::radians(m_fov));
+	}
+
+	// Returns the radius, in pixels, of a sphere seen by the camera.
+	inline float computeProjectedRadius(const glm::vec3& center, float radius, float viewportHeight) const {
+		return computeProjectedSize(radius, glm::max(glm::length(center - m_pos), radius), viewportHeight);
+	}
+
 private:
 	glm::vec3 m_pos = glm::vec3(0, 0, 0);
 	glm::vec3 m_center = glm::vec3(0, 0, 0);
@@ -0,0 +1,57 @@
+#ifndef INCLUDE_CPUFEATURES
+#define INCLUDE_CPUFEATURES
+
+// Runtime detection of the SIMD instruction sets, so a single binary can pick the fastest kernels.
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define CPU_FEATURES_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC accepts any intrinsic anywhere, GCC and Clang need the functions using AVX2 to be marked
+#if defined(CPU_FEATURES_X86) && (defined(__GNUC__) || defined(__clang__))
+#define CPU_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define CPU_TARGET_AVX2
+#endif
+
+class CpuFeatures
+{
+public:
+	/*
+	* @brief Whether SSE2 can be used. Always true on x86-64.
+	*/
+	inline static bool hasSse2()
+	{
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	/*
+	* @brief Whether AVX2 and FMA can be used, by both the processor and the operating system.
+	*/
+	inline static bool hasAvx2()
+	{
+#if !defined(CPU_FEATURES_X86)
+		return false;
+#elif defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 1);
+		const bool osSavesYmm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6;
+		const bool fma = (info[2] & (1 << 12)) != 0;
+		__cpuidex(info, 7, 0);
+		const bool avx2 = (info[1] & (1 << 5)) != 0;
+		return osSavesYmm && fma && avx2;
+#else
+		return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+	}
+};
+
+#endif
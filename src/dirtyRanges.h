@@ -0,0 +1,88 @@
+#ifndef INCLUDE_DIRTYRANGES
+#define INCLUDE_DIRTYRANGES
+
+#include <algorithm>
+#include <cstddef>
+
+/*
+* @brief The modified sub-ranges of an array, merged when they touch, to only upload those.
+* 
+* Holds at most kMaxRanges ranges without any heap allocation: past that, the two neighbouring
+* ranges with the smallest gap are merged, which uploads as few unmodified elements as possible.
+*/
+class DirtyRanges
+{
+public:
+	struct Range
+	{
+		size_t first; // First modified element
+		size_t end;   // One past the last modified element
+	};
+
+	static const int kMaxRanges = 8;
+
+	/*
+	* @brief Marks elements as modified.
+	* 
+	* @param first The first modified element.
+	* @param count The amount of modified elements.
+	*/
+	void add(size_t first, size_t count)
+	{
+		if (count == 0) return;
+		Range added = { first, first + count };
+
+		// Absorb every range touching the new one
+		int kept = 0;
+		for (int i = 0; i < m_count; i++)
+		{
+			if (m_ranges[i].end >= added.first && m_ranges[i].first <= added.end)
+			{
+				added.first = std::min(added.first, m_ranges[i].first);
+				added.end = std::max(added.end, m_ranges[i].end);
+			}
+			else
+			{
+				m_ranges[kept++] = m_ranges[i];
+			}
+		}
+		m_count = kept;
+
+		// Keep the ranges sorted, so that the closest ranges are neighbours
+		int position = m_count;
+		while (position > 0 && m_ranges[position - 1].first > added.first)
+		{
+			m_ranges[position] = m_ranges[position - 1];
+			position--;
+		}
+		m_ranges[position] = added;
+		m_count++;
+
+		if (m_count > kMaxRanges) mergeClosestPair();
+	}
+
+	inline bool empty() const { return m_count == 0; }
+	inline int size() const { return m_count; }
+	inline const Range& operator[](int i) const { return m_ranges[i]; }
+	inline void clear() { m_count = 0; }
+
+private:
+	Range m_ranges[kMaxRanges + 1]; // One more, for the range added before a merge
+	int m_count = 0;
+
+	// The list is over full: merge the two neighbouring ranges with the smallest gap between them.
+	// The ranges are sorted and disjoint, so the merged one stays between its neighbours.
+	void mergeClosestPair()
+	{
+		int closest = 0;
+		for (int i = 1; i < m_count - 1; i++)
+		{
+			if (m_ranges[i + 1].first - m_ranges[i].end < m_ranges[closest + 1].first - m_ranges[closest].end) closest = i;
+		}
+		m_ranges[closest].end = m_ranges[closest + 1].end;
+		for (int i = closest + 1; i < m_count - 1; i++) m_ranges[i] = m_ranges[i + 1];
+		m_count--;
+	}
+};
+
+#endif
@@ -0,0 +1,117 @@
+#include "ephemeris.h"
+
+#include <cmath>
+
+static const double kPi = 3.14159265358979323846;
+
+// Newton's method converges quadratically: a few iterations reach this from the starting guess
+static const double kKeplerTolerance = 1e-14;
+static const int kMaxKeplerIterations = 16;
+
+Ephemeris::Ephemeris(const glm::dvec3& origin) :
+	m_origin(origin)
+{
+}
+
+size_t Ephemeris::addBody(const OrbitalElements& orbit, const SpinElements& spin, int parent)
+{
+	m_bodies.push_back(EphemerisBody{ orbit, spin, parent < (int)m_bodies.size() ? parent : -1 });
+	return m_bodies.size() - 1;
+}
+
+glm::dvec3 Ephemeris::computePosition(size_t body, double time) const
+{
+	// The parents were added first, so the chain always ends
+	glm::dvec3 position = m_origin;
+	for (int index = (int)body; index >= 0; index = m_bodies[index].parent)
+	{
+		position += computeOrbitPosition(m_bodies[index].orbit, time);
+	}
+	return position;
+}
+
+glm::dmat3 Ephemeris::computeOrientation(size_t body, double time) const
+{
+	const SpinElements& spin = m_bodies[body].spin;
+	const double angle = computeAngle(spin.angleAtEpoch, spin.period, time);
+
+	// Turns around Y, then tilts Y toward +X
+	const double cosAngle = std::cos(angle), sinAngle = std::sin(angle);
+	const glm::dmat3 rotation(
+		glm::dvec3(cosAngle, 0.0, -sinAngle),
+		glm::dvec3(0.0, 1.0, 0.0),
+		glm::dvec3(sinAngle, 0.0, cosAngle));
+
+	const double cosTilt = std::cos(spin.axialTilt), sinTilt = std::sin(spin.axialTilt);
+	const glm::dmat3 tilt(
+		glm::dvec3(cosTilt, -sinTilt, 0.0),
+		glm::dvec3(sinTilt, cosTilt, 0.0),
+		glm::dvec3(0.0, 0.0, 1.0));
+
+	return tilt * rotation;
+}
+
+glm::dvec3 Ephemeris::computeOrbitPosition(const OrbitalElements& orbit, double time)
+{
+	const double e = orbit.eccentricity;
+	const double meanAnomaly = computeAngle(orbit.meanAnomalyAtEpoch, orbit.period, time);
+	const double eccentricAnomaly = solveKepler(meanAnomaly, e);
+
+	// In the plane of the orbit, x toward the periapsis
+	const double x = orbit.semiMajorAxis * (std::cos(eccentricAnomaly) - e);
+	const double y = orbit.semiMajorAxis * std::sqrt(1.0 - e * e) * std::sin(eccentricAnomaly);
+
+	glm::dvec3 periapsis, ahead;
+	computeOrbitAxes(orbit, periapsis, ahead);
+	return x * periapsis + y * ahead;
+}
+
+void Ephemeris::computeOrbitAxes(const OrbitalElements& orbit, glm::dvec3& periapsis, glm::dvec3& ahead)
+{
+	// Rotated by the argument of periapsis, the inclination and the longitude of the node,
+	// into a frame whose z is the north of the reference plane
+	const double cosPeriapsis = std::cos(orbit.argumentOfPeriapsis), sinPeriapsis = std::sin(orbit.argumentOfPeriapsis);
+	const double cosInclination = std::cos(orbit.inclination), sinInclination = std::sin(orbit.inclination);
+	const double cosNode = std::cos(orbit.ascendingNode), sinNode = std::sin(orbit.ascendingNode);
+
+	auto toWorld = [&](double x, double y) {
+		const double nodeX = x * cosPeriapsis - y * sinPeriapsis;
+		const double nodeY = (x * sinPeriapsis + y * cosPeriapsis) * cosInclination;
+		const double north = (x * sinPeriapsis + y * cosPeriapsis) * sinInclination;
+
+		const double referenceX = nodeX * cosNode - nodeY * sinNode;
+		const double referenceY = nodeX * sinNode + nodeY * cosNode;
+
+		// Y is the north in the world, and a positive angle turns +X toward -Z
+		return glm::dvec3(referenceX, north, -referenceY);
+	};
+	periapsis = toWorld(1.0, 0.0);
+	ahead = toWorld(0.0, 1.0);
+}
+
+double Ephemeris::solveKepler(double meanAnomaly, double eccentricity)
+{
+	// Third order starting guess, or the aphelion for the very eccentric orbits where it may overshoot
+	double eccentricAnomaly = eccentricity < 0.8
+		? meanAnomaly + eccentricity * std::sin(meanAnomaly) * (1.0 + eccentricity * std::cos(meanAnomaly))
+		: (meanAnomaly < 0.0 ? -kPi : kPi);
+
+	for (int iteration = 0; iteration < kMaxKeplerIterations; iteration++)
+	{
+		const double delta = (eccentricAnomaly - eccentricity * std::sin(eccentricAnomaly) - meanAnomaly)
+			/ (1.0 - eccentricity * std::cos(eccentricAnomaly));
+		eccentricAnomaly -= delta;
+		if (std::abs(delta) < kKeplerTolerance) break;
+	}
+	return eccentricAnomaly;
+}
+
+double Ephemeris::computeAngle(double angleAtEpoch, double period, double time)
+{
+	if (period == 0.0) return angleAtEpoch;
+
+	// The turns done since the epoch are dropped before scaling, so that no precision is lost to them
+	double turns = time / period;
+	turns -= std::floor(turns);
+	return std::remainder(angleAtEpoch + 2.0 * kPi * turns, 2.0 * kPi);
+}
@@ -0,0 +1,128 @@
+#ifndef INCLUDE_EPHEMERIS
+#define INCLUDE_EPHEMERIS
+
+#include <dep/glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+/*
+* @brief The Keplerian orbit of a body around its parent, the angles in radians.
+*
+* The reference plane is the XZ plane of the world, Y pointing to its north, and the angles measured
+* from +X turn toward -Z, as a positive rotation around +Y.
+*/
+struct OrbitalElements
+{
+	double semiMajorAxis = 0.0;       // In world units
+	double eccentricity = 0.0;        // 0 for a circle, below 1
+	double inclination = 0.0;         // Of the orbit plane, to the reference plane
+	double ascendingNode = 0.0;       // Longitude of the ascending node
+	double argumentOfPeriapsis = 0.0; // From the ascending node
+	double meanAnomalyAtEpoch = 0.0;  // At time 0
+	double period = 1.0;              // Of one orbit, in seconds, negative for a retrograde orbit
+};
+
+/*
+* @brief The rotation of a body around its own axis, the angles in radians.
+*/
+struct SpinElements
+{
+	double period = 0.0;       // Of one turn, in seconds, negative for a retrograde spin, 0 for none
+	double axialTilt = 0.0;    // Of the spin axis, from +Y toward +X
+	double angleAtEpoch = 0.0; // At time 0
+};
+
+/*
+* @brief Places the bodies at any time from their orbital elements, in constant time.
+*
+* Nothing is accumulated from one time to the next: seeking to any date costs the same as the next
+* tick, and the positions do not drift however long the simulation runs. The times are doubles, so
+* that a step of a frame is still resolved after years of simulation.
+*/
+class Ephemeris
+{
+public:
+	/*
+	* @param origin The center the bodies without a parent orbit around, e.g. the sun.
+	*/
+	explicit Ephemeris(const glm::dvec3& origin = glm::dvec3(0.0));
+
+	/*
+	* @brief Adds a body to place.
+	*
+	* @param orbit The orbit of the body around its parent.
+	* @param spin The rotation of the body around itself.
+	* @param parent The index of the body it orbits around, added before it, or -1 for the origin.
+	*
+	* @return The index of the body.
+	*/
+	size_t addBody(const OrbitalElements& orbit, const SpinElements& spin, int parent = -1);
+
+	inline size_t getBodyCount() const { return m_bodies.size(); }
+
+	/*
+	* @brief Get the center of a body in the world.
+	*
+	* @param body The index of the body.
+	* @param time The time, in seconds since the epoch.
+	*/
+	glm::dvec3 computePosition(size_t body, double time) const;
+
+	/*
+	* @brief Get the rotation from the frame of a body, its spin axis being Y, to the world.
+	*
+	* @param body The index of the body.
+	* @param time The time, in seconds since the epoch.
+	*/
+	glm::dmat3 computeOrientation(size_t body, double time) const;
+
+	/*
+	* @brief Get the position of an orbiting body relative to the focus of its orbit.
+	*
+	* @param orbit The orbit of the body.
+	* @param time The time, in seconds since the epoch.
+	*/
+	static glm::dvec3 computeOrbitPosition(const OrbitalElements& orbit, double time);
+
+	/*
+	* @brief Get the axes of the plane of an orbit in the world, the position being a (cos(E) - e) periapsis + b sin(E) ahead.
+	*
+	* @param orbit The orbit.
+	* @param periapsis Receives the unit vector from the focus toward the periapsis.
+	* @param ahead Receives the unit vector a quarter of a turn ahead of it, in the direction of the orbit.
+	*/
+	static void computeOrbitAxes(const OrbitalElements& orbit, glm::dvec3& periapsis, glm::dvec3& ahead);
+
+	/*
+	* @brief Solves Kepler's equation M = E - e sin(E) with Newton's method.
+	*
+	* @param meanAnomaly M, in radians, in [-pi, pi].
+	* @param eccentricity e, in [0, 1).
+	*
+	* @return The eccentric anomaly E, in radians.
+	*/
+	static double solveKepler(double meanAnomaly, double eccentricity);
+
+	/*
+	* @brief Get an angle growing with time, wrapped in [-pi, pi] before it loses precision.
+	*
+	* @param angleAtEpoch The angle at time 0, in radians.
+	* @param period The time of a full turn, negative to turn the other way, 0 for a constant angle.
+	* @param time The time, in seconds since the epoch.
+	*/
+	static double computeAngle(double angleAtEpoch, double period, double time);
+
+private:
+	struct EphemerisBody
+	{
+		OrbitalElements orbit;
+		SpinElements spin;
+		int parent;
+	};
+
+	glm::dvec3 m_origin;
+	std::vector<EphemerisBody> m_bodies;
+};
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef INCLUDE_FIXEDTIMESTEP
+#define INCLUDE_FIXEDTIMESTEP
+
+#include <cmath>
+#include <cstddef>
+
+/*
+* @brief Turns the time between frames into a whole amount of simulation steps of a fixed duration.
+*
+* The time left over is kept for the next frame, so the simulation follows the clock at any frame rate,
+* and getAlpha() tells how far the clock is between the last two steps, to interpolate what is drawn.
+* After a stall, at most maxSteps are run in a frame and the rest is dropped: the simulation slows
+* down for a moment instead of spending ever longer frames catching up.
+*/
+class FixedTimestep
+{
+public:
+	/*
+	* @param step The duration of a step, in seconds.
+	* @param maxSteps The most steps run by a single advance().
+	*/
+	FixedTimestep(double step, size_t maxSteps) :
+		m_step(step), m_maxSteps(maxSteps)
+	{
+	}
+
+	/*
+	* @brief Adds the time elapsed since the last call.
+	*
+	* @param now The time of a monotonic clock, in seconds, as a double: a float only resolves about 1 ms after 4 hours.
+	*
+	* @return The amount of steps to run now, 0 on the first call.
+	*/
+	size_t advance(double now)
+	{
+		if (!m_started)
+		{
+			m_started = true;
+			m_lastTime = now;
+			return 0;
+		}
+
+		m_accumulator += now - m_lastTime;
+		m_lastTime = now;
+
+		size_t steps = (size_t)std::floor(m_accumulator / m_step);
+		m_accumulator -= steps * m_step;
+		if (steps > m_maxSteps)
+		{
+			m_droppedTime += (steps - m_maxSteps) * m_step;
+			steps = m_maxSteps;
+		}
+		return steps;
+	}
+
+	/*
+	* @brief Get where the clock is between the last step and the next one, from 0 to 1.
+	*/
+	inline double getAlpha() const { return m_accumulator / m_step; }
+
+	inline double getStep() const { return m_step; }
+
+	/*
+	* @brief Get the time that was not simulated because of the maxSteps limit, in seconds.
+	*/
+	inline double getDroppedTime() const { return m_droppedTime; }
+
+private:
+	double m_step;
+	size_t m_maxSteps;
+
+	bool m_started = false;
+	double m_lastTime = 0.0;
+	double m_accumulator = 0.0; // Time not simulated yet, below a step after advance()
+	double m_droppedTime = 0.0;
+};
+
+#endif
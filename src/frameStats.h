@@ -0,0 +1,43 @@
+#ifndef INCLUDE_FRAMESTATS
+#define INCLUDE_FRAMESTATS
+
+#include <cstddef>
+
+/*
+* @brief Counters of the work done during a frame, reset by endFrame().
+*/
+struct FrameStats
+{
+	size_t bytesStreamed = 0; // Written to the GPU through the StreamBuffers
+	size_t bytesUploaded = 0; // Sent with glBufferData/glBufferSubData
+	size_t bytesCopied = 0;   // Copied from one CPU buffer to another before being sent
+
+	/*
+	* @brief The counters of the frame being built.
+	*/
+	static FrameStats& current()
+	{
+		static FrameStats stats;
+		return stats;
+	}
+
+	/*
+	* @brief The counters of the last finished frame.
+	*/
+	static FrameStats& last()
+	{
+		static FrameStats stats;
+		return stats;
+	}
+
+	/*
+	* @brief Called once per frame, after the buffers are swapped.
+	*/
+	static void endFrame()
+	{
+		last() = current();
+		current() = FrameStats();
+	}
+};
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef INCLUDE_FRUSTUM
+#define INCLUDE_FRUSTUM
+
+#include <dep/glm/glm.hpp>
+
+/*
+* @brief The six planes bounding what a camera sees, to skip what is off-screen before drawing it.
+*/
+class Frustum
+{
+public:
+	/*
+	* @brief Extracts the planes of a view-projection matrix, their normals pointing inside.
+	*
+	* @param viewProjection The projection matrix multiplied by the view matrix.
+	*/
+	inline explicit Frustum(const glm::mat4& viewProjection)
+	{
+		// Gribb and Hartmann: each plane is the last row of the matrix plus or minus one of the others
+		const glm::mat4 rows = glm::transpose(viewProjection);
+		for (int axis = 0; axis < 3; axis++)
+		{
+			m_planes[2 * axis] = rows[3] + rows[axis];
+			m_planes[2 * axis + 1] = rows[3] - rows[axis];
+		}
+		for (glm::vec4& plane : m_planes)
+		{
+			plane /= glm::length(glm::vec3(plane));
+		}
+	}
+
+	/*
+	* @brief Whether a sphere may be seen. Spheres near the corners of the frustum may be kept while outside.
+	*
+	* @param center The world coordinates of the center of the sphere.
+	* @param radius The radius of the sphere.
+	*/
+	inline bool intersectsSphere(const glm::vec3& center, float radius) const
+	{
+		for (const glm::vec4& plane : m_planes)
+		{
+			if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) return false;
+		}
+		return true;
+	}
+
+private:
+	// Left, right, bottom, top, near, far, as (normal, distance)
+	glm::vec4 m_planes[6];
+};
+
+#endif
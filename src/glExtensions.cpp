@@ -0,0 +1,41 @@
+#include "glExtensions.h"
+
+#include <cstring>
+
+PFNGLBUFFERSTORAGEPROC_EXT GLExtensions::bufferStorage = nullptr;
+PFNGLPATCHPARAMETERIPROC_EXT GLExtensions::patchParameteri = nullptr;
+int GLExtensions::s_major = 3;
+int GLExtensions::s_minor = 3;
+
+void GLExtensions::load(GLADloadfunc loader)
+{
+	glGetIntegerv(GL_MAJOR_VERSION, &s_major);
+	glGetIntegerv(GL_MINOR_VERSION, &s_minor);
+
+	if (hasVersion(4, 4) || hasExtension("GL_ARB_buffer_storage"))
+	{
+		bufferStorage = (PFNGLBUFFERSTORAGEPROC_EXT)loader("glBufferStorage");
+	}
+
+	if (hasVersion(4, 0))
+	{
+		patchParameteri = (PFNGLPATCHPARAMETERIPROC_EXT)loader("glPatchParameteri");
+	}
+}
+
+bool GLExtensions::hasVersion(int major, int minor)
+{
+	return s_major > major || (s_major == major && s_minor >= minor);
+}
+
+bool GLExtensions::hasExtension(const char* name)
+{
+	GLint count = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+	for (GLint i = 0; i < count; i++)
+	{
+		const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, (GLuint)i);
+		if (extension && std::strcmp(extension, name) == 0) return true;
+	}
+	return false;
+}
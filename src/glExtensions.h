@@ -0,0 +1,64 @@
+#ifndef INCLUDE_GLEXTENSIONS
+#define INCLUDE_GLEXTENSIONS
+
+#include <glad/gl.h>
+
+// The GLAD loader only covers the OpenGL 3.3 core profile, the newer entry points used
+// when the context supports them are loaded here.
+
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+#define GL_CLIENT_STORAGE_BIT 0x0200
+#endif
+
+#ifndef GL_PATCHES
+#define GL_PATCHES 0x000E
+#define GL_PATCH_VERTICES 0x8E72
+#define GL_TESS_EVALUATION_SHADER 0x8E87
+#define GL_TESS_CONTROL_SHADER 0x8E88
+#endif
+
+typedef void (GLAD_API_PTR* PFNGLBUFFERSTORAGEPROC_EXT)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+typedef void (GLAD_API_PTR* PFNGLPATCHPARAMETERIPROC_EXT)(GLenum pname, GLint value);
+
+class GLExtensions
+{
+public:
+	/*
+	* @brief Loads the entry points beyond OpenGL 3.3 that the current context supports.
+	* Must be called once the context is current and GLAD is loaded.
+	* 
+	* @param loader The function returning the address of an OpenGL function, e.g. glfwGetProcAddress.
+	*/
+	static void load(GLADloadfunc loader);
+
+	/*
+	* @brief Whether the context is at least of the given version.
+	*/
+	static bool hasVersion(int major, int minor);
+
+	/*
+	* @brief Whether the context exposes an extension, e.g. "GL_ARB_buffer_storage".
+	*/
+	static bool hasExtension(const char* name);
+
+	/*
+	* @brief Whether immutable, persistently mappable buffers are available (GL 4.4 or GL_ARB_buffer_storage).
+	*/
+	inline static bool hasBufferStorage() { return bufferStorage != nullptr; }
+
+	/*
+	* @brief Whether tessellation shaders are available (GL 4.0). The shaders use #version 400, so the extension alone is not enough.
+	*/
+	inline static bool hasTessellation() { return patchParameteri != nullptr; }
+
+	static PFNGLBUFFERSTORAGEPROC_EXT bufferStorage;
+	static PFNGLPATCHPARAMETERIPROC_EXT patchParameteri;
+
+private:
+	static int s_major, s_minor;
+};
+
+#endif
@@ -0,0 +1,48 @@
+#include "gravitySimulation.h"
+
+GravitySimulation::GravitySimulation(ThreadPool* threadPool) :
+	m_threadPool(threadPool), m_solver(threadPool)
+{
+}
+
+size_t GravitySimulation::addBody(const glm::dvec3& position, const glm::dvec3& velocity, double mass)
+{
+	m_positions.push_back(position);
+	m_velocities.push_back(velocity);
+	m_masses.push_back(mass);
+	m_accelerationsValid = false;
+	return m_positions.size() - 1;
+}
+
+void GravitySimulation::clear()
+{
+	m_positions.clear();
+	m_velocities.clear();
+	m_accelerations.clear();
+	m_masses.clear();
+	m_accelerationsValid = false;
+}
+
+void GravitySimulation::step(double duration)
+{
+	if (!m_accelerationsValid) computeAccelerations();
+
+	// Half a kick and a drift, then the other half of the kick with the forces at the new positions
+	const double halfDuration = 0.5 * duration;
+	forEachBody([&](size_t body) {
+		m_velocities[body] += halfDuration * m_accelerations[body];
+		m_positions[body] += duration * m_velocities[body];
+	});
+	computeAccelerations();
+	forEachBody([&](size_t body) {
+		m_velocities[body] += halfDuration * m_accelerations[body];
+	});
+}
+
+void GravitySimulation::computeAccelerations()
+{
+	m_accelerations.resize(m_positions.size());
+	m_solver.build(m_positions.data(), m_masses.data(), m_positions.size());
+	m_interactionCount = m_solver.computeAccelerations(m_accelerations.data());
+	m_accelerationsValid = true;
+}
@@ -0,0 +1,95 @@
+#ifndef INCLUDE_GRAVITYSIMULATION
+#define INCLUDE_GRAVITYSIMULATION
+
+#include "barnesHut.h"
+#include "threadPool.h"
+
+#include <dep/glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+/*
+* @brief Bodies moving under their mutual gravity, integrated with a leapfrog scheme.
+*
+* The kick-drift-kick leapfrog is symplectic: with a fixed step the orbits keep their energy over
+* millions of steps instead of spiraling in or out, for a single evaluation of the forces per step.
+* The forces come from a BarnesHut octree, so the steps are identical with any amount of workers.
+*/
+class GravitySimulation
+{
+public:
+	/*
+	* @param threadPool The workers building the octree and evaluating the forces, nullptr to do it on the calling thread.
+	*/
+	explicit GravitySimulation(ThreadPool* threadPool = nullptr);
+
+	/*
+	* @brief Adds a body.
+	*
+	* @param position Its position, in world units.
+	* @param velocity Its velocity, in world units per second.
+	* @param mass Its mass, 0 for a test particle attracted by the others but not attracting them.
+	*
+	* @return The index of the body.
+	*/
+	size_t addBody(const glm::dvec3& position, const glm::dvec3& velocity, double mass);
+
+	/*
+	* @brief Removes every body.
+	*/
+	void clear();
+
+	/*
+	* @brief Advances every body by a step.
+	*
+	* @param duration The duration of the step, in seconds, best kept the same from one step to the next.
+	*/
+	void step(double duration);
+
+	inline size_t getBodyCount() const { return m_positions.size(); }
+	inline const glm::dvec3& getPosition(size_t body) const { return m_positions[body]; }
+	inline const glm::dvec3& getVelocity(size_t body) const { return m_velocities[body]; }
+	inline const glm::dvec3* getPositions() const { return m_positions.data(); }
+
+	/*
+	* @brief Get the solver of the forces, to set its opening angle, softening and gravitational constant.
+	*/
+	inline BarnesHut& getSolver() { return m_solver; }
+
+	/*
+	* @brief Get the amount of interactions evaluated by the last step.
+	*/
+	inline size_t getInteractionCount() const { return m_interactionCount; }
+
+private:
+	ThreadPool* m_threadPool;
+	BarnesHut m_solver;
+
+	std::vector<glm::dvec3> m_positions, m_velocities, m_accelerations;
+	std::vector<double> m_masses;
+
+	// The accelerations at the current positions, computed at the end of the last step
+	bool m_accelerationsValid = false;
+	size_t m_interactionCount = 0;
+
+	void computeAccelerations();
+
+	/*
+	* @brief Runs a function on every body, on the workers if there are any.
+	*/
+	template <typename F>
+	void forEachBody(F function)
+	{
+		if (m_threadPool != nullptr)
+		{
+			m_threadPool->parallelFor(m_positions.size(), function);
+		}
+		else
+		{
+			for (size_t body = 0; body < m_positions.size(); body++) function(body);
+		}
+	}
+};
+
+#endif
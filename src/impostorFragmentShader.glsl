@@ -0,0 +1,58 @@
+#version 330 core	     // Minimal GL version support expected from the GPU
+
+struct Material {
+	sampler2DArray albedoTex; // texture unit, relate to glActivateTexture(GL_TEXTURE0 + i), one layer per body
+};
+
+uniform Material material;
+uniform mat4 viewMat, projMat;
+uniform vec3 camPos;
+
+in vec3 fPosition; // On the billboard
+flat in vec3 fCenter;
+flat in float fRadius;
+flat in mat3 fLocalFromWorld;
+flat in float fTextureLayer;
+flat in float fEmissive;
+
+out vec4 color; // Shader output: the color response attached to this fragment
+
+const float kPi = 3.14159265358979;
+
+// Defined in lighting.glsl
+vec3 shadeBody(vec3 position, vec3 normal, vec3 albedo, float emissive);
+
+void main() {
+	// Ray from the camera through the fragment, against the sphere
+	vec3 direction = normalize(fPosition - camPos);
+	vec3 fromCenter = camPos - fCenter;
+	float b = dot(fromCenter, direction);
+	float discriminant = b * b - dot(fromCenter, fromCenter) + fRadius * fRadius;
+
+	// The misses keep to the closest point of the ray, so that the texture derivatives stay defined
+	// around the silhouette, and are discarded at the end
+	float t = -b - sqrt(max(discriminant, 0.0));
+	vec3 position = camPos + t * direction;
+	vec3 normal = (position - fCenter) / fRadius;
+
+	// The depth of the sphere, not of the billboard
+	vec4 clipPosition = projMat * viewMat * vec4(position, 1.0);
+	gl_FragDepth = 0.5 * (gl_DepthRange.diff * clipPosition.z / clipPosition.w + gl_DepthRange.near + gl_DepthRange.far);
+
+	// Equirectangular mapping, as on the meshes: u follows the longitude, v the colatitude from +z
+	vec3 local = normalize(fLocalFromWorld * normal);
+	float longitude = atan(local.y, local.x) / (2.0 * kPi); // In [-0.5, 0.5]
+	vec2 texCoord = vec2(fract(longitude), acos(clamp(local.z, -1.0, 1.0)) / kPi);
+
+	// fract() jumps at u = 0 and longitude at u = 0.5: the derivatives come from whichever is continuous,
+	// otherwise the seam samples the smallest mipmap
+	vec2 dLongitude = vec2(dFdx(longitude), dFdy(longitude));
+	vec2 dFract = vec2(dFdx(texCoord.x), dFdy(texCoord.x));
+	vec2 du = abs(dLongitude.x) + abs(dLongitude.y) < abs(dFract.x) + abs(dFract.y) ? dLongitude : dFract;
+	vec3 texColor = textureGrad(material.albedoTex, vec3(texCoord, fTextureLayer),
+		vec2(du.x, dFdx(texCoord.y)), vec2(du.y, dFdy(texCoord.y))).rgb;
+
+	if (discriminant < 0.0) discard;
+
+	color = vec4(shadeBody(position, normal, texColor, fEmissive), 1.0); // Building RGBA from RGB
+}
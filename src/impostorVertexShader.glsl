@@ -0,0 +1,52 @@
+#version 330 core            // Minimal GL version support expected from the GPU
+
+// No vertex attribute: each body is a billboard of four vertices computed from gl_VertexID,
+// facing the camera and just covering the silhouette of the sphere, which impostorFragmentShader ray-casts
+
+// Five texels per body: the four columns of the model matrix, then the texture layer and emissive flag
+uniform samplerBuffer bodies;
+uniform int firstTexel; // Of the first body of the draw call
+
+// Sent to impostorFragmentShader
+out vec3 fPosition;                // On the billboard
+flat out vec3 fCenter;
+flat out float fRadius;
+flat out mat3 fLocalFromWorld;     // Rotates a world direction to the local space of the body
+flat out float fTextureLayer;
+flat out float fEmissive;
+
+uniform mat4 viewMat, projMat;
+uniform vec3 camPos;
+
+void main() {
+        int texel = firstTexel + 5 * gl_InstanceID;
+        mat4 modelMat = mat4(texelFetch(bodies, texel), texelFetch(bodies, texel + 1), texelFetch(bodies, texel + 2), texelFetch(bodies, texel + 3));
+        vec4 material = texelFetch(bodies, texel + 4);
+
+        // Bodies are only scaled uniformly
+        vec3 center = modelMat[3].xyz;
+        float radius = length(modelMat[0].xyz);
+
+        // The billboard goes through the center, across the view direction, with right x up towards the camera
+        vec3 forward = center - camPos;
+        float distance = length(forward);
+        forward /= distance;
+        vec3 right = normalize(cross(forward, abs(forward.y) < 0.99 ? vec3(0.0, 1.0, 0.0) : vec3(1.0, 0.0, 0.0)));
+        vec3 up = cross(right, forward);
+
+        // Where the cone tangent to the sphere from the camera crosses the billboard
+        // The camera is never inside a body drawn as an impostor, those are small on screen
+        float halfSize = radius * distance / sqrt(max(distance * distance - radius * radius, 1e-6 * radius * radius));
+
+        // Triangle strip: bottom left, bottom right, top left, top right
+        vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 2.0 - 1.0;
+        vec3 worldPosition = center + halfSize * (corner.x * right + corner.y * up);
+        gl_Position = projMat * viewMat * vec4(worldPosition, 1.0);
+
+        fPosition = worldPosition;
+        fCenter = center;
+        fRadius = radius;
+        fLocalFromWorld = transpose(mat3(modelMat)) / radius;
+        fTextureLayer = material.x;
+        fEmissive = material.y;
+}
@@ -0,0 +1,362 @@
+#include "keplerKernel.h"
+#include "cpuFeatures.h"
+
+#include <cmath>
+
+static const float kTwoPi = 6.28318530717958647692f;
+static const float kInverseTwoPi = 0.15915494309189533577f;
+static const float kTwoOverPi = 0.63661977236758134308f;
+
+// Pi / 2 in three parts, the first ones with few significant bits so that j * part is exact (Cody-Waite reduction)
+static const float kHalfPiA = 1.5703125f;
+static const float kHalfPiB = 4.837512969970703125e-4f;
+static const float kHalfPiC = 7.54978995489188216e-8f;
+
+// Minimax polynomials of sin and cos on [-pi / 4, pi / 4], from Cephes
+static const float kSin1 = -1.6666654611e-1f, kSin2 = 8.3321608736e-3f, kSin3 = -1.9515295891e-4f;
+static const float kCos1 = 4.166664568298827e-2f, kCos2 = -1.388731625493765e-3f, kCos3 = 2.443315711809948e-5f;
+
+// Danby's starting guess E = M + 0.85 e sign(M) is never far, whatever the eccentricity
+static const float kStartingGuess = 0.85f;
+
+void KeplerOrbitsSoA::resize(size_t count)
+{
+	m_count = count;
+	const size_t padded = (count + 7) & ~(size_t)7;
+	for (std::vector<float>* array : { &meanAnomaly, &meanMotion, &eccentricity, &semiMajorAxis, &semiMinorAxis, &px, &py, &pz, &qx, &qy, &qz })
+	{
+		array->resize(padded, 0.0f);
+	}
+	m_meanAnomalyAtZero.resize(count, 0.0);
+	m_period.resize(count, 0.0);
+}
+
+void KeplerOrbitsSoA::set(size_t i, const OrbitalElements& orbit)
+{
+	m_meanAnomalyAtZero[i] = orbit.meanAnomalyAtEpoch;
+	m_period[i] = orbit.period;
+	meanAnomaly[i] = (float)Ephemeris::computeAngle(orbit.meanAnomalyAtEpoch, orbit.period, m_epoch);
+	meanMotion[i] = (float)(2.0 * 3.14159265358979323846 / orbit.period);
+	eccentricity[i] = (float)orbit.eccentricity;
+	semiMajorAxis[i] = (float)orbit.semiMajorAxis;
+	semiMinorAxis[i] = (float)(orbit.semiMajorAxis * std::sqrt(1.0 - orbit.eccentricity * orbit.eccentricity));
+
+	glm::dvec3 periapsis, ahead;
+	Ephemeris::computeOrbitAxes(orbit, periapsis, ahead);
+	px[i] = (float)periapsis.x;
+	py[i] = (float)periapsis.y;
+	pz[i] = (float)periapsis.z;
+	qx[i] = (float)ahead.x;
+	qy[i] = (float)ahead.y;
+	qz[i] = (float)ahead.z;
+}
+
+void KeplerOrbitsSoA::rebase(double time)
+{
+	for (size_t i = 0; i < m_count; i++) meanAnomaly[i] = (float)Ephemeris::computeAngle(m_meanAnomalyAtZero[i], m_period[i], time);
+	m_epoch = time;
+}
+
+static void sinCosScalar(float x, float& sine, float& cosine)
+{
+	const int quadrant = (int)std::lrint(x * kTwoOverPi);
+	const float j = (float)quadrant;
+	const float r = ((x - j * kHalfPiA) - j * kHalfPiB) - j * kHalfPiC;
+	const float r2 = r * r;
+	const float sinR = r + r * r2 * (kSin1 + r2 * (kSin2 + r2 * kSin3));
+	const float cosR = 1.0f - 0.5f * r2 + r2 * r2 * (kCos1 + r2 * (kCos2 + r2 * kCos3));
+
+	sine = (quadrant & 1) ? cosR : sinR;
+	cosine = (quadrant & 1) ? sinR : cosR;
+	if (quadrant & 2) sine = -sine;
+	if ((quadrant + 1) & 2) cosine = -cosine;
+}
+
+// Solves a single lane, as the SIMD implementations do
+static float solveScalar(float meanAnomaly, float e, float& sinE, float& cosE)
+{
+	const float m = meanAnomaly - kTwoPi * (float)std::lrint(meanAnomaly * kInverseTwoPi);
+	float eccentricAnomaly = m + (m < 0.0f ? -kStartingGuess : kStartingGuess) * e;
+
+	float sine = 0.0f, cosine = 1.0f, delta = 0.0f;
+	for (int iteration = 0; iteration < KeplerKernel::kIterations; iteration++)
+	{
+		sinCosScalar(eccentricAnomaly, sine, cosine);
+		const float f = eccentricAnomaly - e * sine - m;
+		const float f1 = 1.0f - e * cosine;
+		const float f2 = e * sine;
+		delta = 2.0f * f * f1 / (2.0f * f1 * f1 - f * f2);
+		eccentricAnomaly -= delta;
+	}
+
+	// The last step is tiny, its first order is enough to move the sine and cosine along
+	sinE = sine - delta * cosine;
+	cosE = cosine + delta * sine;
+	return eccentricAnomaly;
+}
+
+static void solveRangeScalar(const float* meanAnomaly, const float* eccentricity, float* eccentricAnomaly, size_t first, size_t last)
+{
+	float sinE, cosE;
+	for (size_t i = first; i < last; i++) eccentricAnomaly[i] = solveScalar(meanAnomaly[i], eccentricity[i], sinE, cosE);
+}
+
+static void positionsScalar(const KeplerOrbitsSoA& o, float time, const glm::vec3& focus, float* positionX, float* positionY, float* positionZ, size_t first, size_t last)
+{
+	for (size_t i = first; i < last; i++)
+	{
+		float sinE, cosE;
+		solveScalar(o.meanAnomaly[i] + o.meanMotion[i] * time, o.eccentricity[i], sinE, cosE);
+		const float x = o.semiMajorAxis[i] * (cosE - o.eccentricity[i]);
+		const float y = o.semiMinorAxis[i] * sinE;
+		positionX[i] = focus.x + x * o.px[i] + y * o.qx[i];
+		positionY[i] = focus.y + x * o.py[i] + y * o.qy[i];
+		positionZ[i] = focus.z + x * o.pz[i] + y * o.qz[i];
+	}
+}
+
+#if defined(CPU_FEATURES_X86)
+
+static inline void sinCosSse(__m128 x, __m128& sine, __m128& cosine)
+{
+	// Rounded to the nearest, as lrint() does
+	const __m128i quadrant = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(kTwoOverPi)));
+	const __m128 j = _mm_cvtepi32_ps(quadrant);
+	const __m128 r = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(x, _mm_mul_ps(j, _mm_set1_ps(kHalfPiA))),
+		_mm_mul_ps(j, _mm_set1_ps(kHalfPiB))), _mm_mul_ps(j, _mm_set1_ps(kHalfPiC)));
+	const __m128 r2 = _mm_mul_ps(r, r);
+
+	const __m128 sinR = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(r, r2),
+		_mm_add_ps(_mm_set1_ps(kSin1), _mm_mul_ps(r2, _mm_add_ps(_mm_set1_ps(kSin2), _mm_mul_ps(r2, _mm_set1_ps(kSin3)))))));
+	const __m128 cosR = _mm_add_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(_mm_set1_ps(0.5f), r2)), _mm_mul_ps(_mm_mul_ps(r2, r2),
+		_mm_add_ps(_mm_set1_ps(kCos1), _mm_mul_ps(r2, _mm_add_ps(_mm_set1_ps(kCos2), _mm_mul_ps(r2, _mm_set1_ps(kCos3)))))));
+
+	// The odd quadrants swap the sine and cosine, the sign bits come from the quadrant bits
+	const __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+	const __m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(2)), 30));
+	const __m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(2)), 30));
+	sine = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, cosR), _mm_andnot_ps(swap, sinR)), sinSign);
+	cosine = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, sinR), _mm_andnot_ps(swap, cosR)), cosSign);
+}
+
+static inline __m128 solveSse(__m128 meanAnomaly, __m128 e, __m128& sinE, __m128& cosE)
+{
+	const __m128 m = _mm_sub_ps(meanAnomaly, _mm_mul_ps(_mm_set1_ps(kTwoPi),
+		_mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_mul_ps(meanAnomaly, _mm_set1_ps(kInverseTwoPi))))));
+
+	// The sign of m given to the starting guess
+	const __m128 signBit = _mm_set1_ps(-0.0f);
+	const __m128 guess = _mm_or_ps(_mm_set1_ps(kStartingGuess), _mm_and_ps(m, signBit));
+	__m128 eccentricAnomaly = _mm_add_ps(m, _mm_mul_ps(guess, e));
+
+	const __m128 one = _mm_set1_ps(1.0f), two = _mm_set1_ps(2.0f);
+	__m128 sine = _mm_setzero_ps(), cosine = one, delta = _mm_setzero_ps();
+	for (int iteration = 0; iteration < KeplerKernel::kIterations; iteration++)
+	{
+		sinCosSse(eccentricAnomaly, sine, cosine);
+		const __m128 f = _mm_sub_ps(_mm_sub_ps(eccentricAnomaly, _mm_mul_ps(e, sine)), m);
+		const __m128 f1 = _mm_sub_ps(one, _mm_mul_ps(e, cosine));
+		const __m128 f2 = _mm_mul_ps(e, sine);
+		delta = _mm_div_ps(_mm_mul_ps(_mm_mul_ps(two, f), f1), _mm_sub_ps(_mm_mul_ps(_mm_mul_ps(two, f1), f1), _mm_mul_ps(f, f2)));
+		eccentricAnomaly = _mm_sub_ps(eccentricAnomaly, delta);
+	}
+
+	sinE = _mm_sub_ps(sine, _mm_mul_ps(delta, cosine));
+	cosE = _mm_add_ps(cosine, _mm_mul_ps(delta, sine));
+	return eccentricAnomaly;
+}
+
+static void solveRangeSse(const float* meanAnomaly, const float* eccentricity, float* eccentricAnomaly, size_t count)
+{
+	__m128 sinE, cosE;
+	for (size_t i = 0; i + 4 <= count; i += 4)
+	{
+		_mm_storeu_ps(&eccentricAnomaly[i], solveSse(_mm_loadu_ps(&meanAnomaly[i]), _mm_loadu_ps(&eccentricity[i]), sinE, cosE));
+	}
+	solveRangeScalar(meanAnomaly, eccentricity, eccentricAnomaly, count & ~(size_t)3, count);
+}
+
+static void positionsSse(const KeplerOrbitsSoA& o, float time, const glm::vec3& focus, float* positionX, float* positionY, float* positionZ, size_t first, size_t last)
+{
+	const __m128 t = _mm_set1_ps(time);
+	const __m128 fx = _mm_set1_ps(focus.x), fy = _mm_set1_ps(focus.y), fz = _mm_set1_ps(focus.z);
+
+	// The range is padded to a multiple of 8, so of 4 as well
+	for (size_t i = first; i < last; i += 4)
+	{
+		const __m128 e = _mm_loadu_ps(&o.eccentricity[i]);
+		__m128 sinE, cosE;
+		solveSse(_mm_add_ps(_mm_loadu_ps(&o.meanAnomaly[i]), _mm_mul_ps(_mm_loadu_ps(&o.meanMotion[i]), t)), e, sinE, cosE);
+
+		const __m128 x = _mm_mul_ps(_mm_loadu_ps(&o.semiMajorAxis[i]), _mm_sub_ps(cosE, e));
+		const __m128 y = _mm_mul_ps(_mm_loadu_ps(&o.semiMinorAxis[i]), sinE);
+		_mm_storeu_ps(&positionX[i], _mm_add_ps(fx, _mm_add_ps(_mm_mul_ps(x, _mm_loadu_ps(&o.px[i])), _mm_mul_ps(y, _mm_loadu_ps(&o.qx[i])))));
+		_mm_storeu_ps(&positionY[i], _mm_add_ps(fy, _mm_add_ps(_mm_mul_ps(x, _mm_loadu_ps(&o.py[i])), _mm_mul_ps(y, _mm_loadu_ps(&o.qy[i])))));
+		_mm_storeu_ps(&positionZ[i], _mm_add_ps(fz, _mm_add_ps(_mm_mul_ps(x, _mm_loadu_ps(&o.pz[i])), _mm_mul_ps(y, _mm_loadu_ps(&o.qz[i])))));
+	}
+}
+
+CPU_TARGET_AVX2
+static inline void sinCosAvx2(__m256 x, __m256& sine, __m256& cosine)
+{
+	const __m256i quadrant = _mm256_cvtps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(kTwoOverPi)));
+	const __m256 j = _mm256_cvtepi32_ps(quadrant);
+	const __m256 r = _mm256_fnmadd_ps(j, _mm256_set1_ps(kHalfPiC),
+		_mm256_fnmadd_ps(j, _mm256_set1_ps(kHalfPiB), _mm256_fnmadd_ps(j, _mm256_set1_ps(kHalfPiA), x)));
+	const __m256 r2 = _mm256_mul_ps(r, r);
+
+	const __m256 sinR = _mm256_fmadd_ps(_mm256_mul_ps(r, r2),
+		_mm256_fmadd_ps(r2, _mm256_fmadd_ps(r2, _mm256_set1_ps(kSin3), _mm256_set1_ps(kSin2)), _mm256_set1_ps(kSin1)), r);
+	const __m256 cosR = _mm256_fmadd_ps(_mm256_mul_ps(r2, r2),
+		_mm256_fmadd_ps(r2, _mm256_fmadd_ps(r2, _mm256_set1_ps(kCos3), _mm256_set1_ps(kCos2)), _mm256_set1_ps(kCos1)),
+		_mm256_fnmadd_ps(_mm256_set1_ps(0.5f), r2, _mm256_set1_ps(1.0f)));
+
+	const __m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(quadrant, _mm256_set1_epi32(1)), _mm256_set1_epi32(1)));
+	const __m256 sinSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(quadrant, _mm256_set1_epi32(2)), 30));
+	const __m256 cosSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(_mm256_add_epi32(quadrant, _mm256_set1_epi32(1)), _mm256_set1_epi32(2)), 30));
+	sine = _mm256_xor_ps(_mm256_blendv_ps(sinR, cosR, swap), sinSign);
+	cosine = _mm256_xor_ps(_mm256_blendv_ps(cosR, sinR, swap), cosSign);
+}
+
+CPU_TARGET_AVX2
+static inline __m256 solveAvx2(__m256 meanAnomaly, __m256 e, __m256& sinE, __m256& cosE)
+{
+	const __m256 m = _mm256_fnmadd_ps(_mm256_set1_ps(kTwoPi),
+		_mm256_round_ps(_mm256_mul_ps(meanAnomaly, _mm256_set1_ps(kInverseTwoPi)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC), meanAnomaly);
+
+	const __m256 guess = _mm256_or_ps(_mm256_set1_ps(kStartingGuess), _mm256_and_ps(m, _mm256_set1_ps(-0.0f)));
+	__m256 eccentricAnomaly = _mm256_fmadd_ps(guess, e, m);
+
+	const __m256 one = _mm256_set1_ps(1.0f), two = _mm256_set1_ps(2.0f);
+	__m256 sine = _mm256_setzero_ps(), cosine = one, delta = _mm256_setzero_ps();
+	for (int iteration = 0; iteration < KeplerKernel::kIterations; iteration++)
+	{
+		sinCosAvx2(eccentricAnomaly, sine, cosine);
+		const __m256 f = _mm256_sub_ps(_mm256_fnmadd_ps(e, sine, eccentricAnomaly), m);
+		const __m256 f1 = _mm256_fnmadd_ps(e, cosine, one);
+		const __m256 f2 = _mm256_mul_ps(e, sine);
+		delta = _mm256_div_ps(_mm256_mul_ps(_mm256_mul_ps(two, f), f1), _mm256_fmsub_ps(_mm256_mul_ps(two, f1), f1, _mm256_mul_ps(f, f2)));
+		eccentricAnomaly = _mm256_sub_ps(eccentricAnomaly, delta);
+	}
+
+	sinE = _mm256_fnmadd_ps(delta, cosine, sine);
+	cosE = _mm256_fmadd_ps(delta, sine, cosine);
+	return eccentricAnomaly;
+}
+
+CPU_TARGET_AVX2
+static void solveRangeAvx2(const float* meanAnomaly, const float* eccentricity, float* eccentricAnomaly, size_t count)
+{
+	__m256 sinE, cosE;
+	for (size_t i = 0; i + 8 <= count; i += 8)
+	{
+		_mm256_storeu_ps(&eccentricAnomaly[i], solveAvx2(_mm256_loadu_ps(&meanAnomaly[i]), _mm256_loadu_ps(&eccentricity[i]), sinE, cosE));
+	}
+	solveRangeScalar(meanAnomaly, eccentricity, eccentricAnomaly, count & ~(size_t)7, count);
+}
+
+CPU_TARGET_AVX2
+static void positionsAvx2(const KeplerOrbitsSoA& o, float time, const glm::vec3& focus, float* positionX, float* positionY, float* positionZ, size_t first, size_t last)
+{
+	const __m256 t = _mm256_set1_ps(time);
+	const __m256 fx = _mm256_set1_ps(focus.x), fy = _mm256_set1_ps(focus.y), fz = _mm256_set1_ps(focus.z);
+
+	for (size_t i = first; i < last; i += 8)
+	{
+		const __m256 e = _mm256_loadu_ps(&o.eccentricity[i]);
+		__m256 sinE, cosE;
+		solveAvx2(_mm256_fmadd_ps(_mm256_loadu_ps(&o.meanMotion[i]), t, _mm256_loadu_ps(&o.meanAnomaly[i])), e, sinE, cosE);
+
+		const __m256 x = _mm256_mul_ps(_mm256_loadu_ps(&o.semiMajorAxis[i]), _mm256_sub_ps(cosE, e));
+		const __m256 y = _mm256_mul_ps(_mm256_loadu_ps(&o.semiMinorAxis[i]), sinE);
+		_mm256_storeu_ps(&positionX[i], _mm256_fmadd_ps(x, _mm256_loadu_ps(&o.px[i]), _mm256_fmadd_ps(y, _mm256_loadu_ps(&o.qx[i]), fx)));
+		_mm256_storeu_ps(&positionY[i], _mm256_fmadd_ps(x, _mm256_loadu_ps(&o.py[i]), _mm256_fmadd_ps(y, _mm256_loadu_ps(&o.qy[i]), fy)));
+		_mm256_storeu_ps(&positionZ[i], _mm256_fmadd_ps(x, _mm256_loadu_ps(&o.pz[i]), _mm256_fmadd_ps(y, _mm256_loadu_ps(&o.qz[i]), fz)));
+	}
+}
+
+#endif
+
+KeplerKernel::Implementation KeplerKernel::detect()
+{
+	if (isSupported(AVX2)) return AVX2;
+	if (isSupported(SSE)) return SSE;
+	return Scalar;
+}
+
+const char* KeplerKernel::getName(Implementation implementation)
+{
+	switch (implementation)
+	{
+	case AVX2: return "AVX2";
+	case SSE: return "SSE";
+	default: return "scalar";
+	}
+}
+
+bool KeplerKernel::isSupported(Implementation implementation)
+{
+	switch (implementation)
+	{
+#if defined(CPU_FEATURES_X86)
+	case AVX2: return CpuFeatures::hasAvx2();
+	case SSE: return CpuFeatures::hasSse2();
+#endif
+	case Scalar: return true;
+	default: return false;
+	}
+}
+
+void KeplerKernel::solve(const float* meanAnomaly, const float* eccentricity, float* eccentricAnomaly, size_t count)
+{
+	// The processor does not change while running, detect it only once
+	static const Implementation best = detect();
+	solve(best, meanAnomaly, eccentricity, eccentricAnomaly, count);
+}
+
+void KeplerKernel::solve(Implementation implementation, const float* meanAnomaly, const float* eccentricity, float* eccentricAnomaly, size_t count)
+{
+	switch (implementation)
+	{
+#if defined(CPU_FEATURES_X86)
+	case AVX2:
+		solveRangeAvx2(meanAnomaly, eccentricity, eccentricAnomaly, count);
+		break;
+	case SSE:
+		solveRangeSse(meanAnomaly, eccentricity, eccentricAnomaly, count);
+		break;
+#endif
+	default:
+		solveRangeScalar(meanAnomaly, eccentricity, eccentricAnomaly, 0, count);
+		break;
+	}
+}
+
+void KeplerKernel::computePositions(const KeplerOrbitsSoA& orbits, double time, const glm::vec3& focus, float* x, float* y, float* z, size_t first, size_t last)
+{
+	static const Implementation best = detect();
+	computePositions(best, orbits, time, focus, x, y, z, first, last);
+}
+
+void KeplerKernel::computePositions(Implementation implementation, const KeplerOrbitsSoA& orbits, double time, const glm::vec3& focus,
+	float* x, float* y, float* z, size_t first, size_t last)
+{
+	// Since the epoch, so that the float keeps the fractions of a second
+	const float elapsed = (float)(time - orbits.getEpoch());
+	last = (last + 7) & ~(size_t)7;
+
+	switch (implementation)
+	{
+#if defined(CPU_FEATURES_X86)
+	case AVX2:
+		positionsAvx2(orbits, elapsed, focus, x, y, z, first, last);
+		break;
+	case SSE:
+		positionsSse(orbits, elapsed, focus, x, y, z, first, last);
+		break;
+#endif
+	default:
+		positionsScalar(orbits, elapsed, focus, x, y, z, first, last);
+		break;
+	}
+}
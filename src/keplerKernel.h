@@ -0,0 +1,138 @@
+#ifndef INCLUDE_KEPLERKERNEL
+#define INCLUDE_KEPLERKERNEL
+
+#include "ephemeris.h"
+#include "vertexKernel.h"
+
+#include <dep/glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+/*
+* @brief Structure-of-arrays storage for the orbits of many small bodies around a single focus.
+*
+* Each orbit is reduced to what moving along it needs: the mean anomaly at the epoch, the mean motion,
+* the eccentricity, the two semi-axes and the two axes of its plane. The arrays are padded to a multiple
+* of 8 floats with orbits of size 0, so the SIMD kernels never need a remainder loop. The mean anomaly
+* at time 0 and the period are also kept in double, for rebase() to derive the float arrays from them.
+*/
+struct KeplerOrbitsSoA
+{
+	std::vector<float> meanAnomaly;   // At getEpoch(), in radians, in [-pi, pi]
+	std::vector<float> meanMotion;    // In radians per second
+	std::vector<float> eccentricity;
+	std::vector<float> semiMajorAxis, semiMinorAxis;
+	std::vector<float> px, py, pz;    // Toward the periapsis
+	std::vector<float> qx, qy, qz;    // A quarter of a turn ahead
+
+	/*
+	* @brief Resizes every array.
+	*
+	* @param count The amount of orbits to store.
+	*/
+	void resize(size_t count);
+
+	inline size_t size() const { return m_count; }
+
+	/*
+	* @brief Stores an orbit.
+	*
+	* @param i The index of the orbit.
+	* @param orbit Its elements, the mean anomaly being the one at time 0.
+	*/
+	void set(size_t i, const OrbitalElements& orbit);
+
+	/*
+	* @brief Moves the epoch of the mean anomalies to a time, in double precision.
+	*
+	* The kernels take the time since the epoch as a float: rebasing every few hundred turns keeps it exact enough.
+	* The mean anomalies are computed again from the elements, so the rounding does not build up from one rebase to the next.
+	*/
+	void rebase(double time);
+
+	inline double getEpoch() const { return m_epoch; }
+
+private:
+	size_t m_count = 0;
+	double m_epoch = 0.0;
+	std::vector<double> m_meanAnomalyAtZero, m_period; // Not padded, the kernels do not read them
+};
+
+/*
+* @brief CPU kernel solving Kepler's equation M = E - e sin(E) for many orbits at once, and placing the bodies.
+*
+* Every lane runs the same fixed amount of Halley iterations from the same starting guess, with no
+* branch nor early exit: the float precision is reached for eccentricities up to 0.99. The sines and
+* cosines are polynomials, evaluated in the SIMD registers. The fastest implementation supported by
+* the processor is picked at runtime, the scalar one runs the same computations a lane at a time.
+*/
+class KeplerKernel
+{
+public:
+	enum Implementation { Scalar, SSE, AVX2 };
+
+	// Halley's method triples the correct digits per iteration, the fourth one is only needed past e = 0.9
+	static const int kIterations = 4;
+
+	/*
+	* @brief Get the fastest implementation the processor supports.
+	*/
+	static Implementation detect();
+
+	/*
+	* @brief Get the human readable name of an implementation.
+	*/
+	static const char* getName(Implementation implementation);
+
+	/*
+	* @brief Whether the processor can run an implementation.
+	*/
+	static bool isSupported(Implementation implementation);
+
+	/*
+	* @brief Solves Kepler's equation for arrays of mean anomalies and eccentricities.
+	*
+	* @param meanAnomaly The mean anomalies M, in radians, any angle.
+	* @param eccentricity The eccentricities e, in [0, 1). The error is within 2e-6 rad up to 0.99, and grows beyond it.
+	* @param eccentricAnomaly Receives the eccentric anomalies E, in radians, in [-pi, pi].
+	* @param count The length of the three arrays.
+	*/
+	static void solve(const float* meanAnomaly, const float* eccentricity, float* eccentricAnomaly, size_t count);
+
+	/*
+	* @brief Same as solve(), with a forced implementation. It must be supported.
+	*/
+	static void solve(Implementation implementation, const float* meanAnomaly, const float* eccentricity, float* eccentricAnomaly, size_t count);
+
+	/*
+	* @brief Computes the positions of a range of the orbits at a time, into three coordinate arrays.
+	*
+	* @param orbits The orbits.
+	* @param time The time, in seconds, best within a few hundred turns of the epoch of the orbits.
+	* @param focus The world coordinates of the focus of the orbits, e.g. the sun.
+	* @param x Receives the x coordinate of orbit i at x[i], must hold as many floats as the padded orbits.
+	* @param y Idem for y.
+	* @param z Idem for z.
+	* @param first The first orbit, a multiple of 8.
+	* @param last One past the last orbit, rounded up to a multiple of 8 within the padding.
+	*/
+	static void computePositions(const KeplerOrbitsSoA& orbits, double time, const glm::vec3& focus, float* x, float* y, float* z, size_t first, size_t last);
+
+	/*
+	* @brief Same as computePositions(), with a forced implementation. It must be supported.
+	*/
+	static void computePositions(Implementation implementation, const KeplerOrbitsSoA& orbits, double time, const glm::vec3& focus,
+		float* x, float* y, float* z, size_t first, size_t last);
+
+	/*
+	* @brief Same as computePositions(), into a VertexSoA as large as the orbits.
+	*/
+	inline static void computePositions(Implementation implementation, const KeplerOrbitsSoA& orbits, double time, const glm::vec3& focus,
+		VertexSoA& positions, size_t first, size_t last)
+	{
+		computePositions(implementation, orbits, time, focus, positions.x.data(), positions.y.data(), positions.z.data(), first, last);
+	}
+};
+
+#endif
@@ -0,0 +1,37 @@
+#version 330 core	     // Minimal GL version support expected from the GPU
+
+// Lighting shared by the fragment shaders of the bodies, linked into their programs
+
+struct Sun {
+	vec3 position;
+	float intensity;    // Light received at a distance of 1
+	float falloff;      // Exponent of the distance in the luminous intensity drop off
+	vec3 emissiveColor; // Light emitted by the emissive bodies themselves
+};
+
+uniform vec3 camPos;
+uniform Sun sun;
+
+// The light a point of a body sends to the camera
+// position and normal are in world space, albedo is the color of the texture at that point
+vec3 shadeBody(vec3 position, vec3 normal, vec3 albedo, float emissive) {
+	vec3 n = normalize(normal);
+
+	// ref: left-right, bottom-top, back-front
+	// right hand
+	// Have a very, very slight luminous intensity drop off the further out we go
+	vec3 lightVector = sun.position - position;
+	vec3 l = sun.intensity * normalize(lightVector) / pow(length(lightVector), sun.falloff);
+	//vec3 l = normalize(vec3(0.,0.,1.));
+
+	vec3 v = normalize(camPos - position);
+
+	// Reflected light = mirrored across the normal AND going away from vertex, not towards it like light vector
+	vec3 r = reflect(-l, n);
+
+	vec3 ambient = emissive * sun.emissiveColor;
+	vec3 diffuse = max(dot(n, l), 0.0) * vec3(1.0, 1.0, 1.0) * albedo;
+	vec3 specular = pow(max(dot(v, r), 0.0), 8) * vec3(1.0, 1.0, 1.0) * albedo;
+
+	return ambient + diffuse + specular;
+}
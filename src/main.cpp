@@ -21,9 +21,23 @@
 #define STB_IMAGE_IMPLEMENTATION
 
 #include "stb_image.h"
+#include "benchmark.h"
+#include "body.h"
 #include "camera.h"
+#include "ephemeris.h"
+#include "fixedTimestep.h"
+#include "frameStats.h"
+#include "frustum.h"
+#include "glExtensions.h"
+#include "gravitySimulation.h"
 #include "mesh.h"
 #include "meshUtility.h"
+#include "orbitTrails.h"
+#include "particleSystem.h"
+#include "proceduralSphere.h"
+#include "sphereLods.h"
+#include "sphereTerrain.h"
+#include "threadPool.h"
 
 #include <glad/gl.h>
 #include <GLFW/glfw3.h>
@@ -31,18 +45,24 @@
 #include <dep/glm/glm.hpp>
 #include <dep/glm/ext.hpp>
 
+#include <algorithm>
 #include <cmath>
 #include <ctime> 
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
 #include <memory>
+#include <random>
 #include <sstream>
 #include <string>
 #include <vector>
 
 void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
 void mouseMotionCallback(GLFWwindow* window, double xpos, double ypos);
+void placeBodies(double time, bool continuous = true);
+void startGravity();
+void stopGravity();
+void initBelts();
 
 // constants
 const static float kSizeSun = 1;
@@ -64,13 +84,28 @@ const static std::vector<float> planetRotItself = { 1.0, 1.47, -1.0, 1.22, 1.0,
 const static std::vector<float> planetRotSun = { 1.0, 0.24, 0.62, 1.88, 11.86, 29.43, 83.76, 163.75, 247.97 };
 
 const static std::vector<float> axialTilt = { 0.41, 0.0, 3.1, 0.44, 0.05, 0.47, 1.71, 0.49, 2.09 };
-static std::vector<float> axialTiltCos = {};
-static std::vector<float> axialTiltSin = {};
-static std::vector<float> orbitInclCos = {};
-static std::vector<float> orbitInclSin = {};
 
 static std::vector<float> orbitIncl = { 0.0, 0.12, 0.06, 0.03, 0.02, 0.04, 0.01, 0.03, 0.3 };
 
+// The real shapes of the orbits: eccentricity, longitude of the ascending node and argument of periapsis, in radians
+const static std::vector<float> orbitEccentricity = { 0.017, 0.206, 0.007, 0.093, 0.048, 0.054, 0.047, 0.009, 0.249 };
+const static std::vector<float> orbitNode = { 0.0, 0.84, 1.34, 0.86, 1.75, 1.98, 1.29, 2.30, 1.93 };
+const static std::vector<float> orbitPeriapsis = { 1.99, 0.51, 0.96, 5.00, 4.78, 5.92, 1.69, 4.77, 1.99 };
+
+// The time of an orbit of planetRotSun 1, in seconds: the orbits used to turn by 120 / slowdownRatio radians per second
+const static double kSecondsPerYear = 2.0 * M_PI * slowdownRatio / 120.0;
+
+// The moon turns around the Earth three times a year, always showing it the same face
+const static double kMoonOrbitsPerYear = 3.0;
+
+// Sun light: intensity / distance^falloff, evaluated in fragmentShader.glsl
+// Real-life has the falloff set not at 0.125, but 2
+// However setting that value to 2 for our model makes things look way too dark
+// Also reminder: 1.33203125 = 10^0.125, so that the intensity is 1 at a distance of 10
+const static float kSunLightFalloff = 0.125f;
+const static float kSunLightIntensity = 1.33203125f;
+const static glm::vec3 kSunEmissiveColor = glm::vec3(1.0f, 1.0f, 0.0f);
+
 const static float x_sun = 0, y_sun = 0, z_sun = 0;
 const static float x_venus = x_sun + kRadOrbitVenus, x_earth = x_sun + kRadOrbitEarth, x_moon = x_earth + kRadOrbitMoon;
 
@@ -80,18 +115,97 @@ int nbPlanetsToRender = 9;
 
 // Window parameters
 GLFWwindow* g_window = nullptr;
+int g_viewportHeight = 864;
+const std::string windowTitle = "Interactive 3D Applications (OpenGL) - Simple Solar System";
 
 // GPU objects
 // A GPU program contains at least a vertex shader and a fragment shader
 GLuint g_program = 0;
 
+// Draws the bodies without any vertex buffer when useProceduralSpheres is set, toggled with P
+// The small bodies are ray-cast impostors when useImpostors is set, toggled with I
+GLuint g_proceduralProgram = 0, g_impostorProgram = 0;
+std::shared_ptr<ProceduralSphere> proceduralSphere;
+bool useProceduralSpheres = false, useImpostors = true;
+
+// With GL 4.0, the bodies drawn with a mesh refine a coarse icosphere in the tessellation shaders instead of
+// picking a level of detail, when useTessellation is set, toggled with V
+GLuint g_tessellationProgram = 0;
+std::shared_ptr<Mesh> tessellationBaseMesh;
+bool useTessellation = true;
+const static size_t kTessellationBaseFrequency = 2; // 80 patches
+const static float kTessellationEdgePixels = 8.0f;
+
+// The last positions of the moon and the planets, drawn as fading lines when showTrails is set, toggled with O
+// A point is appended every kTrailTickInterval simulation steps
+GLuint g_trailProgram = 0;
+std::shared_ptr<OrbitTrails> orbitTrails;
+std::vector<glm::vec3> trailPositions;
+bool showTrails = true;
+size_t trailTicks = 0;
+const static size_t kTrailTickInterval = 4;
+const static size_t kTrailPoints = 512;
+const static glm::vec3 kTrailColor = glm::vec3(0.4f, 0.6f, 1.0f);
+
 // Basic camera model
 Camera g_camera;
 
-// Toy mesh for a sphere
-std::shared_ptr<Mesh> sphereMesh;
-std::shared_ptr<Mesh> sunSphere, venusSphere, earthSphere, moonSphere;
-std::vector < std::shared_ptr<Mesh> > planets;
+// Toy mesh for a sphere at several levels of detail, shared by every body
+const static std::vector<size_t> sphereLodResolutions = { 8, 16, 32, 64, 128, 256, 512 };
+const static std::string meshCacheDirectory = backoutPath + "cache/"; // The meshes too slow to generate at every run, see MeshFile
+std::shared_ptr<SphereLods> sphereLods;
+std::shared_ptr<Body> sunSphere, venusSphere, earthSphere, moonSphere;
+std::vector < std::shared_ptr<Body> > planets;
+
+// Places the planets, then the moon, at simulationTime, in seconds since the start, advanced by steps in update()
+Ephemeris ephemeris;
+size_t moonEphemerisIndex = 0;
+double simulationTime = 0.0;
+const static double kSeekYears = 10.0; // Jumped forward with J
+
+// When useGravity is set, toggled with N, the sun, the planets, the moon and test particles move under their mutual gravity
+// instead of following the ephemeris, starting from where it put them. The masses are in suns, the spins still come from the ephemeris.
+std::shared_ptr<GravitySimulation> gravitySimulation;
+bool useGravity = false;
+const static double kSunMass = 1.0, kMoonMass = 3.7e-8;
+const static std::vector<double> planetMasses = { 3.0e-6, 1.66e-7, 2.45e-6, 3.23e-7, 9.55e-4, 2.86e-4, 4.37e-5, 5.15e-5, 6.6e-9 };
+// An orbit of radius orbitRadii[0] around the sun lasts kSecondsPerYear
+const static double kGravitationalConstant = 4.0 * M_PI * M_PI * 1000.0 / (kSecondsPerYear * kSecondsPerYear);
+const static double kGravityOpeningAngle = 0.5, kGravitySoftening = 1e-3;
+// Massless test particles, on circular orbits between Mars and Jupiter
+const static size_t kGravityParticles = 2000;
+const static float kGravityParticlesMinRadius = 20.0f, kGravityParticlesMaxRadius = 45.0f;
+
+// Workers for the CPU work that can be done off the main thread
+std::shared_ptr<ThreadPool> threadPool;
+
+// The main belt, between Mars and Jupiter, and the Kuiper belt, past Neptune, drawn as points with the gravity test particles
+// when showParticles is set, toggled with B
+struct BeltDescription
+{
+	size_t particleCount;
+	float minRadius, maxRadius;          // Of the orbits, in world units
+	float maxEccentricity, maxInclination;
+	float particleRadius;
+	glm::vec4 color;
+};
+const static std::vector<BeltDescription> belts = {
+	{ 600000, 21.0f, 33.0f, 0.25f, 0.35f, 0.02f, glm::vec4(0.62f, 0.56f, 0.48f, 0.9f) },
+	{ 400000, 300.0f, 480.0f, 0.2f, 0.5f, 0.08f, glm::vec4(0.55f, 0.65f, 0.8f, 0.9f) },
+};
+GLuint g_particleProgram = 0;
+std::shared_ptr<ParticleSystem> particleSystem;
+bool showParticles = true;
+const static float kMaxParticlePixels = 8.0f;
+const static float kGravityParticleRadius = 0.05f;
+const static glm::vec4 kGravityParticleColor = glm::vec4(1.0f, 0.45f, 0.3f, 1.0f);
+
+// Finer geometry for the bodies seen from close, shared by every body
+std::shared_ptr<SphereTerrain> sphereTerrain;
+
+// The bodies drawn this frame, and how many of them use each level of detail
+std::vector<Body*> drawnBodies, impostorBodies;
+std::vector<size_t> drawnBodiesPerLod;
 
 // Translation matrixes
 glm::mat4 g_sun, g_venus, g_earth, g_moon;
@@ -100,11 +214,15 @@ glm::mat4 g_sun, g_venus, g_earth, g_moon;
 //glm::mat4 earth_rot{ glm::mat4(1.) }, moon_rot{ glm::mat4(1.) };
 
 // Texture vars
-GLuint g_sunTexID, g_moonTexID;
-std::vector <GLuint> texIDs;
+// One layer per planet, in the order of the planets vector, then the moon and the sun
+GLuint g_bodyTexArrayID;
+const static int kMoonTexLayer = 9, kSunTexLayer = 10;
 
 // Updating vars
-float fps = 60, lastUpdateTime = 0, fpsSkip = 120.0 / fps;
+// The simulation advances by steps of a nominal frame whatever the frame rate, catching up at most kMaxStepsPerFrame at once
+const static double kSimulationStep = 1.0 / 60.0;
+const static size_t kMaxStepsPerFrame = 8;
+FixedTimestep simulationClock(kSimulationStep, kMaxStepsPerFrame);
 
 // Mouse vars
 bool rightMousePressed = false, leftMousePressed = false, invertedMouseControls = false;
@@ -123,35 +241,52 @@ void printMat4(glm::mat4 a)
 	std::cout << std::endl;
 }
 
-GLuint loadTextureFromFileToGPU(const std::string& filename) {
-	// Loading the image in CPU memory using stb_image
-	//std::cout << "Loading " << backoutPath + filename << "..." << std::endl;
-
-	int width, height, numComponents;
-	unsigned char* data = stbi_load((backoutPath + filename).c_str(), &width, &height, &numComponents, 0);
-
-	if (!data) {
-		std::cerr << "Failed to load texture: " << filename << std::endl;
-		return 0; // Return 0 to indicate failure
-	}
-
+// Loads every image in a layer of a single texture array, so that all the bodies can be drawn at once.
+// All the images must share the size of the first one.
+GLuint loadTextureArrayFromFilesToGPU(const std::vector<std::string>& filenames) {
 	GLuint texID; // OpenGL texture identifier
 	glGenTextures(1, &texID); // generate an OpenGL texture container
-	glBindTexture(GL_TEXTURE_2D, texID); // activate the texture
+	glBindTexture(GL_TEXTURE_2D_ARRAY, texID); // activate the texture
 
 	// Setup the texture filtering option and repeat mode; check www.opengl.org for details.
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
-	// Fill the GPU texture with the data stored in the CPU image
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
+	int layerWidth = 0, layerHeight = 0;
+	for (int layer = 0; layer < (int)filenames.size(); layer++)
+	{
+		// Loading the image in CPU memory using stb_image, always as RGB
+		int width, height, numComponents;
+		unsigned char* data = stbi_load((backoutPath + filenames[layer]).c_str(), &width, &height, &numComponents, 3);
+
+		if (!data) {
+			std::cerr << "Failed to load texture: " << filenames[layer] << std::endl;
+			continue; // The layer stays black
+		}
+
+		if (layer == 0 || layerWidth == 0) {
+			// Allocate every layer at once, sized after the first image
+			layerWidth = width;
+			layerHeight = height;
+			glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGB, layerWidth, layerHeight, (GLsizei)filenames.size(), 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+		}
 
-	// Free useless CPU memory
-	stbi_image_free(data);
-	glBindTexture(GL_TEXTURE_2D, 0); // unbind the texture
-	//std::cout << filename << " loaded." << std::endl;
+		if (width != layerWidth || height != layerHeight) {
+			std::cerr << "Texture " << filenames[layer] << " is " << width << "x" << height
+				<< ", expected " << layerWidth << "x" << layerHeight << std::endl;
+		}
+		else {
+			// Fill the GPU layer with the data stored in the CPU image
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, width, height, 1, GL_RGB, GL_UNSIGNED_BYTE, data);
+		}
+
+		// Free useless CPU memory
+		stbi_image_free(data);
+	}
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0); // unbind the texture
 
 	return texID;
 }
@@ -160,6 +295,7 @@ GLuint loadTextureFromFileToGPU(const std::string& filename) {
 void windowSizeCallback(GLFWwindow* window, int width, int height) {
 	g_camera.setAspectRatio(static_cast<float>(width) / static_cast<float>(height));
 	glViewport(0, 0, (GLint)width, (GLint)height); // Dimension of the rendering region in the window
+	g_viewportHeight = height;
 }
 
 // Executed each time a key is entered.
@@ -196,6 +332,33 @@ void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods
 		else if (key == GLFW_KEY_G && nbPlanetsToRender > 1) {
 			nbPlanetsToRender--;
 		}
+		else if (key == GLFW_KEY_P) {
+			useProceduralSpheres = !useProceduralSpheres;
+		}
+		else if (key == GLFW_KEY_I) {
+			useImpostors = !useImpostors;
+		}
+		else if (key == GLFW_KEY_V) {
+			useTessellation = !useTessellation;
+		}
+		else if (key == GLFW_KEY_O) {
+			showTrails = !showTrails;
+		}
+		else if (key == GLFW_KEY_B) {
+			showParticles = !showParticles;
+		}
+		else if (key == GLFW_KEY_J) {
+			simulationTime += kSeekYears * kSecondsPerYear;
+			placeBodies(simulationTime, false);
+			if (useGravity) startGravity(); // Integrating ten years would take as long as living them
+			orbitTrails->clear(); // Or they would cross the orbits
+		}
+		else if (key == GLFW_KEY_N) {
+			useGravity = !useGravity;
+			if (useGravity) startGravity();
+			else stopGravity();
+			orbitTrails->clear();
+		}
 	}
 }
 
@@ -312,7 +475,7 @@ void initGLFW() {
 	// Create the window
 	g_window = glfwCreateWindow(
 		1536, 864,
-		"Interactive 3D Applications (OpenGL) - Simple Solar System",
+		windowTitle.c_str(),
 		nullptr, nullptr);
 	if (!g_window) {
 		std::cerr << "ERROR: Failed to open window" << std::endl;
@@ -337,11 +500,13 @@ void initOpenGL() {
 		glfwTerminate();
 		std::exit(EXIT_FAILURE);
 	}
+	GLExtensions::load(glfwGetProcAddress);
 
 	glCullFace(GL_BACK); // Specifies the faces to cull (here the ones pointing away from the camera)
 	glEnable(GL_CULL_FACE); // Enables face culling (based on the orientation defined by the CW/CCW enumeration).
 	glDepthFunc(GL_LESS);   // Specify the depth test for the z-buffer
 	glEnable(GL_DEPTH_TEST);      // Enable the z-buffer test in the rasterization
+	glEnable(GL_PROGRAM_POINT_SIZE); // The particles are sized by their vertex shader
 	glClearColor(0.1f, 0.1f, 0.1f, 1.0f); // specify the background color, used any time the framebuffer is cleared
 }
 
@@ -374,27 +539,147 @@ void loadShader(GLuint program, GLenum type, const std::string& shaderFilename)
 	glDeleteShader(shader);
 }
 
-void initGPUprogram() {
-	g_program = glCreateProgram(); // Create a GPU program, i.e., two central shaders of the graphics pipeline
+// Creates a GPU program drawing bodies, its fragment shader being linked with the lighting shared by all of them
+// The tessellation shaders are optional
+GLuint createBodyProgram(const std::string& vertexShaderFilename, const std::string& fragmentShaderFilename,
+	const std::string& tessControlShaderFilename = "", const std::string& tessEvaluationShaderFilename = "") {
+	GLuint program = glCreateProgram(); // Create a GPU program, i.e., two central shaders of the graphics pipeline
+	loadShader(program, GL_VERTEX_SHADER, backoutPath + vertexShaderFilename);
+	if (!tessControlShaderFilename.empty()) loadShader(program, GL_TESS_CONTROL_SHADER, backoutPath + tessControlShaderFilename);
+	if (!tessEvaluationShaderFilename.empty()) loadShader(program, GL_TESS_EVALUATION_SHADER, backoutPath + tessEvaluationShaderFilename);
+	loadShader(program, GL_FRAGMENT_SHADER, backoutPath + fragmentShaderFilename);
+	loadShader(program, GL_FRAGMENT_SHADER, backoutPath + "lighting.glsl");
+	glLinkProgram(program);
+
+	glUseProgram(program);
+	glUniform1i(glGetUniformLocation(program, "material.albedoTex"), 0);
+	return program;
+}
+
+// Loads a GPU program without lighting, and puts it in use
+GLuint createUnlitProgram(const std::string& vertexShaderFilename, const std::string& fragmentShaderFilename) {
+	GLuint program = glCreateProgram();
+	loadShader(program, GL_VERTEX_SHADER, backoutPath + vertexShaderFilename);
+	loadShader(program, GL_FRAGMENT_SHADER, backoutPath + fragmentShaderFilename);
+	glLinkProgram(program);
 
+	glUseProgram(program);
+	return program;
+}
+
+void initGPUprogram() {
 	// The main GPU program handling streams of polygons
-	loadShader(g_program, GL_VERTEX_SHADER, backoutPath + "vertexShader.glsl");
-	loadShader(g_program, GL_FRAGMENT_SHADER, backoutPath + "fragmentShader.glsl");
-	glLinkProgram(g_program);
+	g_program = createBodyProgram("vertexShader.glsl", "fragmentShader.glsl");
 
 	const std::vector<std::string> planetPaths = { "earth","mercury", "venus",  "mars", "jupiter", "saturn", "uranus", "neptune", "pluto" };
+	std::vector<std::string> texturePaths;
 	for each (std::string planetPath in planetPaths)
 	{
-		texIDs.push_back(loadTextureFromFileToGPU("media/" + planetPath + ".jpg"));
+		texturePaths.push_back("media/" + planetPath + ".jpg");
+	}
+
+	texturePaths.push_back("media/moon.jpg"); // kMoonTexLayer
+	texturePaths.push_back("media/sun.jpg"); // kSunTexLayer
+	g_bodyTexArrayID = loadTextureArrayFromFilesToGPU(texturePaths);
+
+	// The same fragment shader, fed by vertices computed from gl_VertexID
+	g_proceduralProgram = createBodyProgram("proceduralVertexShader.glsl", "fragmentShader.glsl");
+
+	// Billboards ray-casting the sphere
+	g_impostorProgram = createBodyProgram("impostorVertexShader.glsl", "impostorFragmentShader.glsl");
+
+	proceduralSphere = std::make_shared<ProceduralSphere>();
+	proceduralSphere->init(g_proceduralProgram, g_impostorProgram, 1); // The body textures are on unit 0
+
+	// Without GL 4.0, the levels of detail of sphereLods are the only path
+	if (GLExtensions::hasTessellation())
+	{
+		g_tessellationProgram = createBodyProgram("tessVertexShader.glsl", "fragmentShader.glsl", "tessControlShader.glsl", "tessEvaluationShader.glsl");
+		glUniform1f(glGetUniformLocation(g_tessellationProgram, "edgePixels"), kTessellationEdgePixels);
+
+		tessellationBaseMesh = Mesh::genSphere(kTessellationBaseFrequency, false, Icosphere);
+		tessellationBaseMesh->defineRenderMethod();
 	}
 
-	g_moonTexID = loadTextureFromFileToGPU("media/moon.jpg");
-	g_sunTexID = loadTextureFromFileToGPU("media/sun.jpg");
+	// Unlit lines, read from the ring buffer of orbitTrails
+	g_trailProgram = createUnlitProgram("trailVertexShader.glsl", "trailFragmentShader.glsl");
+	glUniform3fv(glGetUniformLocation(g_trailProgram, "trailColor"), 1, glm::value_ptr(kTrailColor));
+
+	// One trail for the moon, then one per planet
+	orbitTrails = std::make_shared<OrbitTrails>();
+	orbitTrails->init(g_trailProgram, 2, 1 + planets.size(), kTrailPoints); // Units 0 and 1 are taken by the bodies
+
+	// Unlit points, streamed by particleSystem
+	g_particleProgram = createUnlitProgram("particleVertexShader.glsl", "particleFragmentShader.glsl");
+	glUniform1f(glGetUniformLocation(g_particleProgram, "maxPointSize"), kMaxParticlePixels);
+	particleSystem->init();
 
-	glUniform1i(glGetUniformLocation(g_program, "material.albedoTex"), 0);
 	glUseProgram(g_program);
 }
 
+// Moves the planets and the moon to where the ephemeris puts them at some time, continuous unless they jump there
+void placeBodies(double time, bool continuous) {
+	for (size_t i = 0; i < planets.size(); i++)
+	{
+		planets[i]->place(ephemeris.computePosition(i, time), ephemeris.computeOrientation(i, time), continuous);
+	}
+	moonSphere->place(ephemeris.computePosition(moonEphemerisIndex, time), ephemeris.computeOrientation(moonEphemerisIndex, time), continuous);
+}
+
+// Starts the gravity simulation from the bodies where the ephemeris puts them now, and test particles on circular orbits
+void startGravity() {
+	gravitySimulation->clear();
+
+	const double delta = 1e-3;
+	auto ephemerisVelocity = [delta](size_t index) {
+		return (ephemeris.computePosition(index, simulationTime + delta) - ephemeris.computePosition(index, simulationTime - delta)) / (2.0 * delta);
+	};
+
+	// The sun balances the momentum of the other bodies, so that the system does not drift away
+	glm::dvec3 momentum = kMoonMass * ephemerisVelocity(moonEphemerisIndex);
+	for (size_t i = 0; i < planets.size(); i++) momentum += planetMasses[i] * ephemerisVelocity(i);
+	gravitySimulation->addBody(glm::dvec3(x_sun, y_sun, z_sun), -momentum / kSunMass, kSunMass);
+
+	// The planets follow the sun, then the moon
+	for (size_t i = 0; i < planets.size(); i++)
+	{
+		gravitySimulation->addBody(ephemeris.computePosition(i, simulationTime), ephemerisVelocity(i), planetMasses[i]);
+	}
+	gravitySimulation->addBody(ephemeris.computePosition(moonEphemerisIndex, simulationTime), ephemerisVelocity(moonEphemerisIndex), kMoonMass);
+
+	// The same particles every time, so that the runs can be compared
+	std::mt19937 random(1);
+	std::uniform_real_distribution<double> uniform(0.0, 1.0);
+	for (size_t particle = 0; particle < kGravityParticles; particle++)
+	{
+		const double radius = kGravityParticlesMinRadius + (kGravityParticlesMaxRadius - kGravityParticlesMinRadius) * uniform(random);
+		const double angle = 2.0 * M_PI * uniform(random);
+		const double height = 0.02 * radius * (2.0 * uniform(random) - 1.0);
+		const double speed = std::sqrt(kGravitationalConstant * kSunMass / radius);
+		gravitySimulation->addBody(glm::dvec3(x_sun + radius * std::cos(angle), y_sun + height, z_sun - radius * std::sin(angle)),
+			speed * glm::dvec3(-std::sin(angle), 0.0, -std::cos(angle)), 0.0);
+	}
+}
+
+// Puts the bodies back on the ephemeris
+void stopGravity() {
+	particleSystem->setFreeParticles(nullptr, 0, kGravityParticleRadius, kGravityParticleColor);
+	placeBodies(simulationTime, false);
+	sunSphere->place(glm::vec3(x_sun, y_sun, z_sun), glm::mat3(1.0f), false);
+}
+
+// Advances the gravity simulation by a step, and places the bodies where it moved them, spinning as the ephemeris says
+void stepGravity() {
+	gravitySimulation->step(kSimulationStep);
+
+	sunSphere->place(glm::vec3(gravitySimulation->getPosition(0)), glm::mat3(1.0f));
+	for (size_t i = 0; i < planets.size(); i++)
+	{
+		planets[i]->place(glm::vec3(gravitySimulation->getPosition(1 + i)), ephemeris.computeOrientation(i, simulationTime));
+	}
+	moonSphere->place(glm::vec3(gravitySimulation->getPosition(1 + planets.size())), ephemeris.computeOrientation(moonEphemerisIndex, simulationTime));
+}
+
 /*
 * @brief Set up a 4x4 matrix to move and size the body.
 * 
@@ -416,49 +701,95 @@ void initCPUgeometry() {
 	g_moon = setUpMatrix(kSizeMoon, x_moon, y_sun, z_sun);
 
 	// Reminder: this is here and not earlier because the program needs to init the shaders 'n stuff.
-	sphereMesh = Mesh::genSphere(x_sun, y_sun, z_sun);
+	// The spheres are uploaded once, the bodies only refer to them.
+	// The workers also share the generation of the finest levels, which is only done on the first run
+	threadPool = std::make_shared<ThreadPool>();
+	sphereLods = std::make_shared<SphereLods>();
+	sphereLods->init(sphereLodResolutions, threadPool.get(), meshCacheDirectory);
+
+	sphereTerrain = std::make_shared<SphereTerrain>(threadPool);
 
-	sunSphere = std::make_shared<Mesh>(*sphereMesh);
-	//venusSphere = std::make_shared<Mesh>(*sphereMesh);
-	//earthSphere = std::make_shared<Mesh>(*sphereMesh);
-	moonSphere = std::make_shared<Mesh>(*sphereMesh);
+	gravitySimulation = std::make_shared<GravitySimulation>(threadPool.get());
+	gravitySimulation->getSolver().setGravitationalConstant(kGravitationalConstant);
+	gravitySimulation->getSolver().setOpeningAngle(kGravityOpeningAngle);
+	gravitySimulation->getSolver().setSoftening(kGravitySoftening);
 
-	// Workaround because appearently calling this method in genSphere()'s init()
-	// Doesn't actually work	
-	sunSphere->defineRenderMethod();
-	moonSphere->defineRenderMethod();
+	const glm::vec3 sunCenter = glm::vec3(x_sun, y_sun, z_sun);
+	sunSphere = std::make_shared<Body>(sphereLods);
+	moonSphere = std::make_shared<Body>(sphereLods);
 
 	sunSphere->move(g_sun);
 	moonSphere->move(g_moon);
-	//moonSphere->setupPlanet(0);
 
 	sunSphere->setupSun();
+	sunSphere->setTextureLayer(kSunTexLayer);
+	moonSphere->setTextureLayer(kMoonTexLayer);
 
-	// You will literally never see the difference if this is uncommented because the sun is a solid color
-	//sunSphere->rotateAround(sunSphere.get(), X_ROTATION_VECTOR, -M_PI / 2);
-	
-	/*earthSphere = std::make_shared<Mesh>(*sphereMesh);
-	earthSphere->defineRenderMethod();
-	earthSphere->move(setUpMatrix(kSizeSun * planetSizes[2], x_sun + orbitRadii[2], y_sun, z_sun));
-	earthSphere->setupPlanet(-axialTilt[2]);*/
-
+	// The planets start at random places of their orbits, the ephemeris moves them from there
+	ephemeris = Ephemeris(glm::dvec3(sunCenter));
 	std::srand(static_cast<unsigned int>(std::time(0)));
+	double earthOrbitProgress = 0.0;
 	for (int i = 0; i < 9; i++)
 	{
 		orbitIncl[i] *= 2.0;
 		double orbitProgress = std::rand() % 135 / 180.0 * M_PI;
-		std::shared_ptr<Mesh> planet = std::make_shared<Mesh>(*sphereMesh);
-		planet->defineRenderMethod();
+		std::shared_ptr<Body> planet = std::make_shared<Body>(sphereLods);
 		planet->move(setUpMatrix(kSizeSun * planetSizes[i], x_sun + orbitRadii[i], y_sun, z_sun));
-		planet->setupPlanet(-axialTilt[i], orbitProgress, orbitIncl[i]);
-		if (i == 0) moonSphere->setupPlanet(0, orbitProgress, 0); // moon needs to align with Earth
+		planet->setTextureLayer(i);
 		planets.push_back(planet);
 
-		axialTiltCos.push_back(cos(axialTilt[i]));
-		axialTiltSin.push_back(sin(axialTilt[i]));
+		OrbitalElements orbit;
+		orbit.semiMajorAxis = orbitRadii[i];
+		orbit.eccentricity = orbitEccentricity[i];
+		orbit.inclination = orbitIncl[i];
+		orbit.ascendingNode = orbitNode[i];
+		orbit.argumentOfPeriapsis = orbitPeriapsis[i];
+		orbit.meanAnomalyAtEpoch = orbitProgress;
+		orbit.period = planetRotSun[i] * kSecondsPerYear;
+
+		SpinElements spin;
+		spin.period = planetRotItself[i] * kSecondsPerYear;
+		spin.axialTilt = axialTilt[i];
+		ephemeris.addBody(orbit, spin);
+
+		if (i == 0) earthOrbitProgress = orbitProgress; // moon needs to align with Earth
+	}
+
+	// The moon orbits the Earth, planets[0]
+	OrbitalElements moonOrbit;
+	moonOrbit.semiMajorAxis = kRadOrbitMoon;
+	moonOrbit.meanAnomalyAtEpoch = earthOrbitProgress;
+	moonOrbit.period = kSecondsPerYear / kMoonOrbitsPerYear;
+
+	SpinElements moonSpin;
+	moonSpin.period = moonOrbit.period;
+	moonSpin.angleAtEpoch = earthOrbitProgress;
+	moonEphemerisIndex = ephemeris.addBody(moonOrbit, moonSpin, 0);
+
+	placeBodies(simulationTime);
 
-		orbitInclCos.push_back(cos(orbitIncl[i]));
-		orbitInclSin.push_back(sin(orbitIncl[i]));
+	particleSystem = std::make_shared<ParticleSystem>(threadPool.get());
+	initBelts();
+}
+
+// Puts the particles of the belts on random orbits around the sun, the same ones every run
+void initBelts() {
+	std::mt19937 random(2);
+	std::uniform_real_distribution<double> uniform(0.0, 1.0);
+	for (const BeltDescription& belt : belts)
+	{
+		for (size_t particle = 0; particle < belt.particleCount; particle++)
+		{
+			OrbitalElements orbit;
+			orbit.semiMajorAxis = belt.minRadius + (belt.maxRadius - belt.minRadius) * uniform(random);
+			orbit.eccentricity = belt.maxEccentricity * uniform(random);
+			orbit.inclination = belt.maxInclination * uniform(random) * uniform(random); // Denser near the plane
+			orbit.ascendingNode = 2.0 * M_PI * uniform(random);
+			orbit.argumentOfPeriapsis = 2.0 * M_PI * uniform(random);
+			orbit.meanAnomalyAtEpoch = 2.0 * M_PI * uniform(random);
+			orbit.period = kSecondsPerYear * std::pow(orbit.semiMajorAxis / orbitRadii[0], 1.5); // Kepler's third law, the Earth at a year
+			particleSystem->addOrbitingParticle(orbit, belt.particleRadius, belt.color);
+		}
 	}
 }
 
@@ -466,6 +797,7 @@ void initCamera() {
 	int width, height;
 	glfwGetWindowSize(g_window, &width, &height);
 	g_camera.setAspectRatio(static_cast<float>(width) / static_cast<float>(height));
+	g_viewportHeight = height;
 
 	// A little bit up high and far away
 	g_camera.setPosition(glm::vec3(0.0, 10.0, 30.0));
@@ -482,73 +814,306 @@ void init() {
 }
 
 void clear() {
+	// The GPU buffers must be freed while the context still exists
+	planets.clear();
+	sunSphere.reset();
+	moonSphere.reset();
+	sphereLods.reset();
+	sphereTerrain.reset();
+	gravitySimulation.reset();
+	particleSystem.reset();
+	threadPool.reset();
+	proceduralSphere.reset();
+	tessellationBaseMesh.reset();
+	orbitTrails.reset();
+
+	glDeleteTextures(1, &g_bodyTexArrayID);
 	glDeleteProgram(g_program);
+	glDeleteProgram(g_proceduralProgram);
+	glDeleteProgram(g_impostorProgram);
+	if (g_tessellationProgram) glDeleteProgram(g_tessellationProgram);
+	glDeleteProgram(g_trailProgram);
+	glDeleteProgram(g_particleProgram);
 
 	glfwDestroyWindow(g_window);
 	glfwTerminate();
 }
 
+// Puts a program in use, and sends it the camera and the light of the frame
+void setSceneUniforms(GLuint program, const glm::mat4& viewMatrix, const glm::mat4& projMatrix) {
+	glUseProgram(program);
+
+	glUniformMatrix4fv(glGetUniformLocation(program, "viewMat"), 1, GL_FALSE, glm::value_ptr(viewMatrix)); // compute the view matrix of the camera and pass it to the GPU program
+	glUniformMatrix4fv(glGetUniformLocation(program, "projMat"), 1, GL_FALSE, glm::value_ptr(projMatrix)); // compute the projection matrix of the camera and pass it to the GPU program
+
+	const glm::vec3 camPosition = g_camera.getPosition();
+	glUniform3f(glGetUniformLocation(program, "camPos"), camPosition[0], camPosition[1], camPosition[2]);
+
+	const glm::vec3 sunPosition = sunSphere->getSelfCenter();
+	glUniform3f(glGetUniformLocation(program, "sun.position"), sunPosition[0], sunPosition[1], sunPosition[2]);
+	glUniform1f(glGetUniformLocation(program, "sun.intensity"), kSunLightIntensity);
+	glUniform1f(glGetUniformLocation(program, "sun.falloff"), kSunLightFalloff);
+
+	// The sun is the only emissive body, its color is the same for every instance
+	glUniform3fv(glGetUniformLocation(program, "sun.emissiveColor"), 1, glm::value_ptr(kSunEmissiveColor));
+}
+
+// Draws the bodies that need no vertex buffer: the ones of impostorBodies as impostors, and if useProceduralSpheres is set
+// the ones of drawnBodies as triangles, one instanced call per level of detail
+void renderProceduralSpheres(const glm::mat4& viewMatrix, const glm::mat4& projMatrix) {
+	const size_t triangleBodies = useProceduralSpheres ? drawnBodies.size() : 0;
+	if (impostorBodies.size() + triangleBodies == 0) return;
+
+	// The impostors come first, then the bodies level after level, each group is then drawn from its first body
+	ProceduralInstance* instances = proceduralSphere->mapInstances(impostorBodies.size() + triangleBodies);
+	for (Body* body : impostorBodies)
+	{
+		*instances++ = ProceduralSphere::makeInstance(body->getInstance());
+	}
+	for (size_t level = 0; level < sphereLods->getLevelCount() && useProceduralSpheres; level++)
+	{
+		for (Body* body : drawnBodies)
+		{
+			if (body->getLodLevel() == (int)level) *instances++ = ProceduralSphere::makeInstance(body->getInstance());
+		}
+	}
+	proceduralSphere->unmapInstances();
+
+	if (!impostorBodies.empty())
+	{
+		setSceneUniforms(g_impostorProgram, viewMatrix, projMatrix);
+		proceduralSphere->renderImpostors(0, impostorBodies.size());
+	}
+
+	if (useProceduralSpheres)
+	{
+		setSceneUniforms(g_proceduralProgram, viewMatrix, projMatrix);
+		size_t first = impostorBodies.size();
+		for (size_t level = 0; level < sphereLods->getLevelCount(); level++)
+		{
+			proceduralSphere->renderInstances(first, drawnBodiesPerLod[level], sphereLods->getResolution(level));
+			first += drawnBodiesPerLod[level];
+		}
+	}
+
+	glUseProgram(g_program);
+}
+
+// Draws every body of drawnBodies with a single instanced call, refining the same base mesh for each on the GPU
+void renderTessellatedSpheres(const glm::mat4& viewMatrix, const glm::mat4& projMatrix) {
+	if (drawnBodies.empty()) return;
+
+	setSceneUniforms(g_tessellationProgram, viewMatrix, projMatrix);
+	glUniform1f(glGetUniformLocation(g_tessellationProgram, "viewportHeight"), (float)g_viewportHeight);
+
+	MeshInstance* instances = tessellationBaseMesh->mapInstances(drawnBodies.size());
+	for (Body* body : drawnBodies)
+	{
+		*instances++ = body->getInstance();
+	}
+	tessellationBaseMesh->unmapInstances();
+	tessellationBaseMesh->renderPatches();
+
+	glUseProgram(g_program);
+}
+
+// Draws every body of drawnBodies with the level of detail picked for it, one instanced call per level
+void renderLodSpheres() {
+	// The bodies sharing a level of detail are drawn with a single instanced call
+	// The instances are written straight into GPU memory
+	for (size_t level = 0; level < sphereLods->getLevelCount(); level++)
+	{
+		if (drawnBodiesPerLod[level] == 0) continue;
+
+		const std::shared_ptr<Mesh>& mesh = sphereLods->getLevel(level);
+		MeshInstance* instances = mesh->mapInstances(drawnBodiesPerLod[level]);
+		for (Body* body : drawnBodies)
+		{
+			if (body->getLodLevel() == (int)level) *instances++ = body->getInstance();
+		}
+		mesh->unmapInstances();
+		mesh->renderMesh();
+	}
+}
+
+// Draws the trails of the moon and of the planets rendered with a single call
+void renderTrails(const glm::mat4& viewMatrix, const glm::mat4& projMatrix) {
+	if (!showTrails) return;
+
+	glUseProgram(g_trailProgram);
+	glUniformMatrix4fv(glGetUniformLocation(g_trailProgram, "viewMat"), 1, GL_FALSE, glm::value_ptr(viewMatrix));
+	glUniformMatrix4fv(glGetUniformLocation(g_trailProgram, "projMat"), 1, GL_FALSE, glm::value_ptr(projMatrix));
+
+	// Tested against the bodies, but not written: the trails do not hide each other
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glDepthMask(GL_FALSE);
+	orbitTrails->render(1 + nbPlanetsToRender);
+	glDepthMask(GL_TRUE);
+	glDisable(GL_BLEND);
+
+	glUseProgram(g_program);
+}
+
+// Draws the belts and the gravity test particles with a single call
+void renderParticles(const glm::mat4& viewMatrix, const glm::mat4& projMatrix) {
+	if (!showParticles) return;
+
+	glUseProgram(g_particleProgram);
+	glUniformMatrix4fv(glGetUniformLocation(g_particleProgram, "viewMat"), 1, GL_FALSE, glm::value_ptr(viewMatrix));
+	glUniformMatrix4fv(glGetUniformLocation(g_particleProgram, "projMat"), 1, GL_FALSE, glm::value_ptr(projMatrix));
+	glUniform1f(glGetUniformLocation(g_particleProgram, "viewportHeight"), (float)g_viewportHeight);
+
+	// Tested against the bodies, but not written: the faded particles blend over each other instead of hiding each other
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glDepthMask(GL_FALSE);
+	particleSystem->render();
+	glDepthMask(GL_TRUE);
+	glDisable(GL_BLEND);
+
+	glUseProgram(g_program);
+}
+
 // The main rendering call
 void render() {
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); // Erase the color and z buffers.
 
 	const glm::mat4 viewMatrix = g_camera.computeViewMatrix();
 	const glm::mat4 projMatrix = g_camera.computeProjectionMatrix();
+	setSceneUniforms(g_program, viewMatrix, projMatrix);
 
-	glUniformMatrix4fv(glGetUniformLocation(g_program, "viewMat"), 1, GL_FALSE, glm::value_ptr(viewMatrix)); // compute the view matrix of the camera and pass it to the GPU program
-	glUniformMatrix4fv(glGetUniformLocation(g_program, "projMat"), 1, GL_FALSE, glm::value_ptr(projMatrix)); // compute the projection matrix of the camera and pass it to the GPU program
-
-	const glm::vec3 camPosition = g_camera.getPosition();
-	glUniform3f(glGetUniformLocation(g_program, "camPos"), camPosition[0], camPosition[1], camPosition[2]);
+	drawnBodies.clear();
+	for (int i = 0; i < nbPlanetsToRender; i++)
+	{
+		drawnBodies.push_back(planets[i].get());
+	}
+	drawnBodies.push_back(moonSphere.get());
+	drawnBodies.push_back(sunSphere.get());
 
 	glActiveTexture(GL_TEXTURE0);
-	for (int i = 0; i < nbPlanetsToRender; i++)
+	glBindTexture(GL_TEXTURE_2D_ARRAY, g_bodyTexArrayID);
+
+	// The bodies seen from close are drawn with the terrain chunks visible from the camera
+	// The others keep to the whole sphere
+	sphereTerrain->update();
+	const Frustum frustum(projMatrix * viewMatrix);
+	size_t sphereBodies = 0;
+	for (Body* body : drawnBodies)
 	{
-		glBindTexture(GL_TEXTURE_2D, texIDs[i]);
-		planets[i]->renderMesh();
+		if (!sphereTerrain->renderBody(*body, g_camera, frustum, (float)g_viewportHeight)) drawnBodies[sphereBodies++] = body;
+	}
+	drawnBodies.resize(sphereBodies);
+
+	// The bodies small on screen are impostors, the others pick the level of detail matching their size on screen
+	drawnBodiesPerLod.assign(sphereLods->getLevelCount(), 0);
+	impostorBodies.clear();
+	size_t meshBodies = 0;
+	for (Body* body : drawnBodies)
+	{
+		const float projectedRadius = g_camera.computeProjectedRadius(body->getSelfCenter(), body->getRadius(), (float)g_viewportHeight);
+		if (useImpostors && ProceduralSphere::isImpostor(projectedRadius))
+		{
+			impostorBodies.push_back(body);
+			continue;
+		}
+		drawnBodiesPerLod[body->updateLodLevel(projectedRadius)]++;
+		drawnBodies[meshBodies++] = body;
 	}
-	//glBindTexture(GL_TEXTURE_2D, texIDs[2]);
-	//earthSphere->renderMesh();
+	drawnBodies.resize(meshBodies);
 
-	glBindTexture(GL_TEXTURE_2D, g_moonTexID);
-	moonSphere->renderMesh();
+	renderProceduralSpheres(viewMatrix, projMatrix);
+	if (!useProceduralSpheres)
+	{
+		if (useTessellation && tessellationBaseMesh) renderTessellatedSpheres(viewMatrix, projMatrix);
+		else renderLodSpheres();
+	}
 
-	// You will literally never see the difference if this is uncommented because the sun is a solid color
-	//glBindTexture(GL_TEXTURE_2D, g_sunTexID);
-	sunSphere->renderMesh();
+	// Blended over the opaque bodies
+	renderParticles(viewMatrix, projMatrix);
+	renderTrails(viewMatrix, projMatrix);
 }
 
 // Update any accessible variable based on the current time
-void update(const float currentTimeInSec) {
-	if ((currentTimeInSec - lastUpdateTime) * fps > 1)
+void update(const double currentTimeInSec) {
+	const size_t steps = simulationClock.advance(currentTimeInSec);
+	for (size_t step = 0; step < steps; step++)
 	{
-		/*venusSphere->rotate(sunSphere.get(), Y_ROTATION_VECTOR, earthRotationSpeed / 1.6);
-		venusSphere->rotate(venusSphere.get(), glm::vec3(10.0, 177.0, 0.0), 2*earthRotationSpeed/3);*/
-		for (int i = 0; i < nbPlanetsToRender; i++)
+		// The bodies are placed from scratch, nothing accumulates between steps
+		simulationTime += kSimulationStep;
+		if (useGravity) stepGravity();
+		else placeBodies(simulationTime);
+
+		// Every trail gets a point in the same upload, the hidden planets included, so that none has a gap when shown again
+		if (++trailTicks % kTrailTickInterval == 0)
 		{
-			planets[i]->rotateAround(sunSphere.get(), glm::vec3(orbitInclSin[i], orbitInclCos[i], 0.0), fpsSkip / (slowdownRatio * planetRotSun[i]));
-			planets[i]->rotateAround(planets[i].get(), glm::vec3(axialTiltSin[i], axialTiltCos[i], 0.0), fpsSkip / (slowdownRatio * planetRotItself[i]));
+			trailPositions.clear();
+			trailPositions.push_back(moonSphere->getSelfCenter());
+			for (const std::shared_ptr<Body>& planet : planets) trailPositions.push_back(planet->getSelfCenter());
+			orbitTrails->append(trailPositions.data());
 		}
-		//earthSphere->rotateAround(sunSphere.get(), Y_ROTATION_VECTOR, planetRotSun[2] / 1000);
-		//earthSphere->rotateAround(earthSphere.get(), glm::vec3(10.0, axialTiltDegrees[2], 0.0), planetRotItself[2] / 1000);
-
-		// The moon moves with the Earth. The Earth moves with the sun. By the transitive property, the moon moves with the sun.
-		moonSphere->rotateAround(sunSphere.get(), Y_ROTATION_VECTOR, fpsSkip * planetRotSun[0] / slowdownRatio);
-		moonSphere->rotateAround(planets[0].get(), Y_ROTATION_VECTOR, fpsSkip * planetRotSun[0] / slowdownRatio * 2);
+	}
 
-		lastUpdateTime = currentTimeInSec;
+	// Drawn where the clock is between the last two steps, a step behind it, so that the motion is smooth at any refresh rate
+	const float alpha = (float)simulationClock.getAlpha();
+	for (const std::shared_ptr<Body>& planet : planets) planet->interpolate(alpha);
+	moonSphere->interpolate(alpha);
+	if (useGravity) sunSphere->interpolate(alpha);
+
+	// The belts need no interpolation, they are placed at the time the bodies are drawn at
+	// The gravity test particles are drawn where the last step left them
+	if (!showParticles) return;
+	const double drawnTime = simulationTime - (1.0 - simulationClock.getAlpha()) * kSimulationStep;
+	if (useGravity)
+	{
+		particleSystem->setFreeParticles(gravitySimulation->getPositions() + 2 + planets.size(), kGravityParticles,
+			kGravityParticleRadius, kGravityParticleColor);
 	}
+	particleSystem->update(drawnTime, sunSphere->getSelfCenter());
+}
+
+// Frame statistics shown in the window title, refreshed every second
+double statsStartTime = 0, lastFrameTime = 0, maxFrameDuration = 0;
+size_t statsFrames = 0, statsBytesStreamed = 0, statsBytesUploaded = 0, statsBytesCopied = 0;
+
+void updateFrameStats(const double currentTimeInSec) {
+	FrameStats::endFrame();
+	statsFrames++;
+	statsBytesStreamed += FrameStats::last().bytesStreamed;
+	statsBytesUploaded += FrameStats::last().bytesUploaded;
+	statsBytesCopied += FrameStats::last().bytesCopied;
+	if (lastFrameTime > 0) maxFrameDuration = std::max(maxFrameDuration, currentTimeInSec - lastFrameTime);
+	lastFrameTime = currentTimeInSec;
+
+	if (currentTimeInSec - statsStartTime < 1.0) return;
+
+	std::ostringstream title;
+	title << windowTitle << " - " << statsFrames / (currentTimeInSec - statsStartTime) << " fps, max "
+		<< maxFrameDuration * 1000.0 << " ms, per frame: " << statsBytesStreamed / statsFrames / 1024.0 << " KB streamed, "
+		<< statsBytesUploaded / statsFrames / 1024.0 << " KB uploaded, " << statsBytesCopied / statsFrames / 1024.0 << " KB copied";
+	glfwSetWindowTitle(g_window, title.str().c_str());
+
+	statsStartTime = currentTimeInSec;
+	statsFrames = 0;
+	statsBytesStreamed = 0;
+	statsBytesUploaded = 0;
+	statsBytesCopied = 0;
+	maxFrameDuration = 0;
 }
 
 int main(int argc, char** argv) {
+	// The CPU micro-benchmarks do not need any window
+	if (argc > 2 && std::string(argv[1]) == "--bench") return runBenchmark(argv[2]);
+
 	init(); // Your initialization code (user interface, OpenGL states, scene with geometry, material, lights, etc)
 
 	while (!glfwWindowShouldClose(g_window)) {
-		update(static_cast<float>(glfwGetTime()));
+		update(glfwGetTime()); // Monotonic, in seconds, as a double
 		glfwPollEvents();
 		render();
 		glfwSwapBuffers(g_window);
 		glfwPollEvents();
+		updateFrameStats(glfwGetTime());
 	}
 	clear();
 	return EXIT_SUCCESS;
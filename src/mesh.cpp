@@ -1,295 +1,493 @@
 #include "mesh.h"
+#include "bakedSpheres.h"
+#include "frameStats.h"
+#include "glExtensions.h"
+#include "meshOptimizer.h"
+#include "uvSphere.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <limits>
 
 
 void Mesh::definePointPosition(int position, float x, float y, float z)
 {
 	int realPos = position;
 
-	m_vertexPositions[realPos] = glm::vec3(x,y,z);
-	m_vertexNormals[realPos] = glm::vec3(x,y,z);
+	// On the unit sphere, the normal is the position itself
+	m_vertices[realPos].position = glm::vec3(x,y,z);
+	m_vertices[realPos].normal = MeshUtility::packNormal(glm::vec3(x,y,z));
 }
 
-void Mesh::defineTrianglePoints(int position, int pt1, int pt2, int pt3)
+void Mesh::defineTextureCoord(int position, float x, float y)
 {
-	int realPos = position;
-	m_triangleIndices[realPos] = pt1;
-	m_triangleIndices[realPos + 1] = pt2;
-	m_triangleIndices[realPos + 2] = pt3;
+	m_vertices[position].texCoord = MeshUtility::packTexCoord(glm::vec2(x, y));
 }
 
-void Mesh::defineTextureCoord(int position, float x, float y)
+void Mesh::sendVertexShader(const PackedVertex* vertices, size_t count, GLuint* vbo)
 {
-	m_vertexTexCoords.push_back(glm::vec2(x, y));
+	size_t bufferSize = sizeof(PackedVertex) * count;
+
+	glGenBuffers(1, vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, *vbo);
+	glBufferData(GL_ARRAY_BUFFER, bufferSize, vertices, GL_STATIC_DRAW);
+	FrameStats::current().bytesUploaded += bufferSize;
+
+	defineVertexAttributes();
 }
 
-void Mesh::definePositions()
+void Mesh::defineVertexAttributes()
 {
-	self_center = glm::vec3(0., 0., 0.);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, position));
+	glEnableVertexAttribArray(0);
 
-	int i = 0;
-	int thetaIndex = 0;
-	int phiIndex = 0;
+	// Packed formats always have 4 components, the shader ignores the last one
+	glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, normal));
+	glEnableVertexAttribArray(1);
 
-	const size_t sizePlusOne = size + (size_t)1;
-	std::vector<float> sinTheta(sizePlusOne), cosTheta(sizePlusOne);
-	std::vector<float> sinPhi(sizePlusOne), cosPhi(sizePlusOne);
+	glVertexAttribPointer(4, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, texCoord));
+	glEnableVertexAttribArray(4);
+}
 
-	for (int index = 0; index < size; ++index) {
-		float theta = (float)M_PI * index / (size - 1); // 0-indexing => size differs
-		sinTheta[index] = sin(theta);
-		cosTheta[index] = cos(theta);
+void Mesh::defineRenderMethod()
+{
+	glGenVertexArrays(1, &m_vao);
+	glBindVertexArray(m_vao);
 
-		float phi = 2.0f * (float)M_PI * index / size;
-		sinPhi[index] = sin(phi);
-		cosPhi[index] = cos(phi);
-	}
+	// The baked meshes are uploaded straight from the binary
+	sendVertexShader(getVertexData(), nbPoints, &m_vbo);
 
-	sinTheta[size] = sinTheta[0];
-	cosTheta[size] = cosTheta[0];
-	sinPhi[size] = sinPhi[0];
-	cosPhi[size] = cosPhi[0];
+	size_t indexBufferSize = m_indexCount * m_indexSize;
 
-	// North point
-	definePointPosition(i, 0, 0, 1);
-	i++;
+	glGenBuffers(1, &m_ibo);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ibo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBufferSize, getIndexData(), GL_STATIC_DRAW);
+	FrameStats::current().bytesUploaded += indexBufferSize;
+	m_dirtyVertices.clear();
+	m_dirtyIndices.clear();
 
-	for (thetaIndex = 1; thetaIndex < size - 1; thetaIndex++)
-	{
-		for (phiIndex = 0; phiIndex < size + 1; phiIndex++, i++)
-		{
-			float x = sinTheta[thetaIndex] * cosPhi[phiIndex];
-			float y = sinTheta[thetaIndex] * sinPhi[phiIndex];
-			float z = cosTheta[thetaIndex];
-			definePointPosition(i, x, y, z);
-		}
-	}
+	defineInstanceAttributes();
 
-	// South point
-	definePointPosition(i, 0, 0, -1);
+	glBindVertexArray(0); // Unbinding
 }
 
-void Mesh::defineTextureCoords()
+void Mesh::defineInstanceAttributes()
 {
-	int index = 0;
-
-	defineTextureCoord(index, 0.5, 0.0);
-	index++;
-	for (int x = 1; x < size - 1; x++)
+	// The pointers are set by bindInstanceAttributes(), once the instances are streamed
+	for (int location = 5; location <= 10; location++)
 	{
-		for (int y = 0; y < size + 1; y++)
-		{
-			float u = static_cast<float>(y) / (size);
-			float v = static_cast<float>(x) / (size - 1);
-			defineTextureCoord(index, u, v);
-			index++;
-		}
+		glEnableVertexAttribArray(location);
+		glVertexAttribDivisor(location, 1); // Advance once per instance, not per vertex
 	}
-	defineTextureCoord(index, 0.5, 1.0);
 }
 
-void Mesh::defineIndices()
+void Mesh::bindInstanceAttributes(GLintptr offset)
 {
-	// Top part
-	int currFaceVertex = 0;
-	int lastTopFV = (int)size * 3;
-	while (currFaceVertex < lastTopFV)
+	// A mat4 attribute takes four consecutive locations, one per column
+	for (int column = 0; column < 4; column++)
 	{
-		defineTrianglePoints(currFaceVertex, 0, currFaceVertex / 3 + 1, currFaceVertex / 3 + 2);
-		currFaceVertex += 3;
+		glVertexAttribPointer(5 + column, 4, GL_FLOAT, GL_FALSE, sizeof(MeshInstance),
+			(void*)(offset + offsetof(MeshInstance, modelMatrix) + column * sizeof(glm::vec4)));
 	}
 
-	const int sizePlusOne = (int)(size + 1);
-	for (int currRow = 0; currRow < size - 3; currRow++)
-	{
-		for (int currCol = 1; currCol < size + 1; currCol++)
-		{
-			// Example: 1-6-2 and 2-6-7 for 5 points a
-			defineTrianglePoints(currFaceVertex, currRow * sizePlusOne + currCol, (currRow + 1) * sizePlusOne + currCol, currRow * sizePlusOne + currCol + 1);
-			currFaceVertex += 3;
+	glVertexAttribPointer(9, 1, GL_FLOAT, GL_FALSE, sizeof(MeshInstance), (void*)(offset + offsetof(MeshInstance, textureLayer)));
+	glVertexAttribPointer(10, 1, GL_FLOAT, GL_FALSE, sizeof(MeshInstance), (void*)(offset + offsetof(MeshInstance, emissive)));
+}
 
-			defineTrianglePoints(currFaceVertex, currRow * sizePlusOne + currCol + 1, (currRow + 1) * sizePlusOne + currCol, (currRow + 1) * sizePlusOne + currCol + 1);
-			currFaceVertex += 3;
-		}
-	}
+MeshInstance* Mesh::mapInstances(size_t count)
+{
+	m_instanceCount = (GLsizei)count;
+	if (count == 0) return nullptr;
 
-	// This isn't working
-	// lastTopFV is not correct
+	// A region the GPU is not reading from, no implicit synchronization nor intermediate copy
+	return (MeshInstance*)m_instanceStream.map(sizeof(MeshInstance) * count);
+}
 
-	// Bottom part
-	lastTopFV = (3 * 2 * (int)size * ((int)size - 2) - currFaceVertex) / 3;
+void Mesh::unmapInstances()
+{
+	if (m_instanceCount == 0) return;
 
-	// Note: This is DELIBERATELY backwards 'cause it's facing AWAY from the screen
-	for (int i = 0; i < lastTopFV - 1; i++)
-	{
-		// Bottom point
-		defineTrianglePoints(currFaceVertex, nbPoints - 1, nbPoints - sizePlusOne + i, nbPoints - 1 - sizePlusOne + i);
-		currFaceVertex += 3;
-	}
-	defineTrianglePoints(currFaceVertex, nbPoints - 1, nbPoints - 1 - sizePlusOne, nbPoints - 2 - sizePlusOne + lastTopFV);
+	const GLintptr offset = m_instanceStream.unmap();
 
+	glBindVertexArray(m_vao);
+	bindInstanceAttributes(offset);
+	glBindVertexArray(0); // Unbinding
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
-template <typename T>
-void Mesh::sendVertexShader(std::vector<T> m_vertexInfo, GLuint* vbo, int location)
+PackedVertex* Mesh::editVertices(size_t first, size_t count)
 {
-	size_t bufferSize = sizeof(T) * m_vertexInfo.size(); // Gather the size of the buffer from the CPU-side vector
-
-	glGenBuffers(1, vbo);
-	glBindBuffer(GL_ARRAY_BUFFER, *vbo);
-	glBufferData(GL_ARRAY_BUFFER, bufferSize, m_vertexInfo.data(), GL_DYNAMIC_DRAW);
-	glVertexAttribPointer(location, 3, GL_FLOAT, GL_FALSE, sizeof(T), 0);
-	glEnableVertexAttribArray(location);
+	assert(first + count <= (size_t)nbPoints);
+	detachExternal();
+	m_dirtyVertices.add(first, count);
+	return m_vertices + first;
 }
 
-void Mesh::defineRenderMethod()
+void* Mesh::editIndices(size_t first, size_t count)
 {
-	glGenVertexArrays(1, &m_vao);
-	glBindVertexArray(m_vao);
+	assert(first + count <= m_indexCount);
+	detachExternal();
+	m_dirtyIndices.add(first, count);
+	return m_indices + first * m_indexSize;
+}
 
-	sendVertexShader(m_vertexPositions, &m_posVbo, 0);
-	sendVertexShader(m_vertexNormals, &m_normVbo, 1);
-	sendVertexShader(m_vertexLight, &m_lightVbo, 2);
-	sendVertexShader(m_vertexAmbience, &m_ambiVbo, 3);
-	sendVertexShader(m_vertexTexCoords, &m_texVbo, 4);
+// Get the size of the modified ranges of an array
+static size_t countRangeBytes(size_t elementSize, const DirtyRanges& dirty)
+{
+	size_t bytes = 0;
+	for (int i = 0; i < dirty.size(); i++) bytes += elementSize * (dirty[i].end - dirty[i].first);
+	return bytes;
+}
 
-	size_t indexBufferSize = sizeof(unsigned int) * m_triangleIndices.size();
+// Sends the modified ranges of a CPU-side array to its buffer, straight from the array
+static void uploadRanges(GLuint buffer, const void* data, size_t elementSize, DirtyRanges& dirty)
+{
+	if (dirty.empty()) return;
 
-	glGenBuffers(1, &m_ibo);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ibo);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBufferSize, m_triangleIndices.data(), GL_DYNAMIC_DRAW);
+	// Bound to the copy target so the VAO's index buffer binding is left alone
+	glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+	for (int i = 0; i < dirty.size(); i++)
+	{
+		const size_t bytes = elementSize * (dirty[i].end - dirty[i].first);
+		glBufferSubData(GL_COPY_WRITE_BUFFER, elementSize * dirty[i].first, bytes, (const char*)data + elementSize * dirty[i].first);
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	dirty.clear();
+}
 
-	glBindVertexArray(0); // Unbinding
+size_t Mesh::getPendingEditBytes() const
+{
+	return countRangeBytes(sizeof(PackedVertex), m_dirtyVertices) + countRangeBytes(m_indexSize, m_dirtyIndices);
 }
 
-void Mesh::init(const size_t resolution)
+void Mesh::uploadEdits()
 {
-	size = resolution;
+	if (m_vao == 0) return; // Not on the GPU yet, everything will be sent by defineRenderMethod()
 
-	nbPoints = (int)(size + 1) * (int)(size - 2) + 2;
-	m_vertexPositions = std::vector<glm::vec3>(nbPoints);
-	m_vertexNormals = std::vector<glm::vec3>(nbPoints);
-	m_vertexLight = std::vector<glm::vec3>(nbPoints);
-	m_vertexAmbience = std::vector<glm::vec3>(nbPoints);
+	FrameStats::current().bytesUploaded += getPendingEditBytes();
+	uploadRanges(m_vbo, m_vertices, sizeof(PackedVertex), m_dirtyVertices);
+	uploadRanges(m_ibo, m_indices, m_indexSize, m_dirtyIndices);
+}
 
-	// size = 3 * 2 * ( nbPoints - n-2 overlapping points - 2 pole points )
-	m_triangleIndices = std::vector<unsigned int>(3 * 2 * size * (size - 2));
+Mesh::~Mesh()
+{
+	if (m_vao == 0) return; // Never sent to the GPU
 
-	definePositions();
-	defineTextureCoords();
-	defineIndices();
+	GLuint vbos[] = { m_vbo, m_ibo };
+	glDeleteBuffers(2, vbos);
+	glDeleteVertexArrays(1, &m_vao);
 }
 
-void Mesh::setupSun()
+void Mesh::defineGeneratedSphere(const SphereTopology topology)
 {
-	for (int i = 0; i < nbPoints; i++) {
-		m_vertexAmbience[i] = glm::vec3(1., 1., 0.);
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec2> texCoords;
+	if (topology == Icosphere) SphereGenerator::genIcosphere(size, positions, m_triangleIndices);
+	else SphereGenerator::genCubeSphere(size, positions, m_triangleIndices);
+	SphereGenerator::defineEquirectangularTexCoords(positions, m_triangleIndices, texCoords);
+
+	// The strips are shorter than the list, and the indices are 32 bits at most
+	nbPoints = (int)positions.size();
+	allocateVertices(nbPoints, sizeof(GLuint) * m_triangleIndices.size());
+	for (int i = 0; i < nbPoints; i++)
+	{
+		definePointPosition(i, positions[i].x, positions[i].y, positions[i].z);
+		defineTextureCoord(i, texCoords[i].x, texCoords[i].y);
 	}
+}
 
-	glBindVertexArray(m_vao);
-	updateRendering(m_vertexAmbience, &m_ambiVbo);
-	glBindVertexArray(0); // Unbinding
+void Mesh::detachExternal()
+{
+	if (m_externalVertices == nullptr) return;
+
+	const size_t indexBytes = m_indexCount * m_indexSize;
+	allocateVertices(nbPoints, indexBytes);
+	std::memcpy(m_vertices, m_externalVertices, sizeof(PackedVertex) * nbPoints);
+	m_indices = m_arena.allocateArray<unsigned char>(indexBytes);
+	std::memcpy(m_indices, m_externalIndices, indexBytes);
+	FrameStats::current().bytesCopied += sizeof(PackedVertex) * nbPoints + indexBytes;
+	dropExternal();
 }
 
-void Mesh::setupPlanet(double angleOfRotationAxis, double orbitProgress, double orbitInclination)
+void Mesh::allocateVertices(size_t vertexCount, size_t indexBytes)
 {
-	rotationalAxis = angleOfRotationAxis;
+	freeStorage();
+	m_arena.reserve(Arena::alignedSize(sizeof(PackedVertex) * vertexCount) + Arena::alignedSize(indexBytes));
+	m_vertices = m_arena.allocateArray<PackedVertex>(vertexCount);
+}
 
-	rotateAround(this, X_ROTATION_VECTOR, -M_PI/2);
-	rotateAround(this, Z_ROTATION_VECTOR, rotationalAxis);
-	rotateAround(sun_center, Z_ROTATION_VECTOR, -orbitInclination);
-	rotateAround(sun_center, glm::vec3(sin(orbitInclination), cos(orbitInclination), 0.0), orbitProgress);
+void Mesh::freeStorage()
+{
+	m_arena.reset();
+	m_vertices = nullptr;
+	m_indices = nullptr;
 }
 
-void Mesh::renderMesh()
+void Mesh::dropExternal()
 {
-	glBindVertexArray(m_vao);     // activate the VAO storing geometry data
-	glDrawElements(GL_TRIANGLES, (GLsizei)m_triangleIndices.size(), GL_UNSIGNED_INT, 0);
-	glBindVertexArray(0); // Unbinding
+	m_externalVertices = nullptr;
+	m_externalIndices = nullptr;
+	m_file.reset();
 }
 
-void Mesh::updateRendering(std::vector<glm::vec3> m_vextexInfo, GLuint *vbo)
+void Mesh::init(const size_t resolution, const bool useStrips, const SphereTopology topology, ThreadPool* threadPool, const std::string& cacheDirectory)
 {
-	size_t bufferSize = sizeof(glm::vec3) * m_vextexInfo.size(); // Gather the size of the buffer from the CPU-side vector
+	const PackedVertex* bakedVertices = nullptr;
+	const std::uint16_t* bakedIndices = nullptr;
+	if (topology != UVSphere || useStrips || !BakedSpheres::find(resolution, bakedVertices, bakedIndices))
+	{
+		if (cacheDirectory.empty())
+		{
+			generate(resolution, useStrips, topology, threadPool);
+			return;
+		}
 
-	glBindBuffer(GL_ARRAY_BUFFER, *vbo);
-	glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(glm::vec3) * m_vextexInfo.size(), m_vextexInfo.data());
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+		const std::string path = cacheDirectory + getCacheFileName(resolution, useStrips, topology);
+		if (load(path, true)) return;
+
+		// Saved with its statistics, they cost nothing to load afterwards
+		generate(resolution, useStrips, topology, threadPool);
+		computeStatistics();
+		std::error_code error;
+		std::filesystem::create_directories(cacheDirectory, error);
+		save(path);
+		return;
+	}
+
+	// Nothing to compute, the mesh is used in place
+	size = resolution;
+	nbPoints = (int)UVSphere::vertexCount(size);
+	freeStorage();
+	dropExternal();
+	m_externalVertices = bakedVertices;
+	m_externalIndices = bakedIndices;
+
+	m_indexType = GL_UNSIGNED_SHORT;
+	m_indexSize = sizeof(GLushort);
+	m_indexCount = UVSphere::indexCount(size);
+	m_primitive = GL_TRIANGLES;
+	m_restartIndex = 0xFFFF;
+	m_acmrBefore = kAcmrNotReordered;
+	m_acmrAfter = m_silhouetteError = 0.0f;
 }
 
-void Mesh::rotateAround(glm::vec3 obCenter, glm::vec3 axisVector, double rotationSpeed)
+void Mesh::generate(const size_t resolution, const bool useStrips, const SphereTopology topology, ThreadPool* threadPool)
 {
-	glm::mat4 matxTrans{ glm::mat4(1.0) };
-	const glm::vec3 selfCenter = getSelfCenter();
+	size = resolution;
+	dropExternal();
+	m_acmrBefore = kAcmrNotReordered;
+	m_acmrAfter = m_silhouetteError = 0.0f;
+
+	if (topology != UVSphere)
+	{
+		defineGeneratedSphere(topology);
+		optimizeIndices(useStrips, true);
+		return;
+	}
+
+	nbPoints = (int)UVSphere::vertexCount(size);
+
+	// The triangles of a list are already in vertex cache order, and reordering would make them differ
+	// from the baked meshes: they are written straight with their final type
+	// Strips are built from a list of 32 bits indices
+	if (useStrips)
+	{
+		m_triangleIndices.resize(UVSphere::indexCount(size));
+		allocateVertices(nbPoints, sizeof(GLuint) * m_triangleIndices.size());
+	}
+	else
+	{
+		selectIndexType();
+		m_primitive = GL_TRIANGLES;
+		m_indexCount = UVSphere::indexCount(size);
+		allocateVertices(nbPoints, m_indexCount * m_indexSize);
+		m_indices = m_arena.allocateArray<unsigned char>(m_indexCount * m_indexSize);
+	}
+
+	// Each band writes its own part of the vertices and indices
+	const bool fitsShort = m_indexType == GL_UNSIGNED_SHORT;
+	auto generateBand = [&](size_t band) {
+		if (useStrips) UVSphere::generateBand(size, band, m_vertices, m_triangleIndices.data());
+		else if (fitsShort) UVSphere::generateBand(size, band, m_vertices, (GLushort*)m_indices);
+		else UVSphere::generateBand(size, band, m_vertices, (GLuint*)m_indices);
+	};
 
-	if (obCenter != getSelfCenter() && rotationalAxis != 0.0f) // only if need to unrotate axis
+	const size_t bandCount = UVSphere::bandCount(size);
+	if (threadPool != nullptr)
 	{
-		glm::mat4 unrotateMatx =
-			// Then moving into orbiting space and doing the orbital rotation
-			MeshUtility::translate(obCenter) *
-			MeshUtility::rotateAroundAxis(axisVector, (float)rotationSpeed) *
-			MeshUtility::translate(-obCenter) *
-
-			// First, removing axial tilt by centering at world space
-			MeshUtility::translate(selfCenter - obCenter) *
-			MeshUtility::rotateAroundAxis(Z_ROTATION_VECTOR, (float)-rotationalAxis) *
-			MeshUtility::translate(obCenter - selfCenter);
-
-		glm::vec3 newSelfCenter = glm::vec3{ unrotateMatx * glm::vec4{selfCenter, 1.0f} };
-
-		matxTrans =
-			MeshUtility::translate(newSelfCenter - obCenter) *
-			MeshUtility::rotateAroundAxis(Z_ROTATION_VECTOR, (float)rotationalAxis) *
-			MeshUtility::translate(obCenter - newSelfCenter) *
-			unrotateMatx;
+		threadPool->parallelFor(bandCount, generateBand);
 	}
 	else
 	{
-		matxTrans = MeshUtility::translate(obCenter) *
-			MeshUtility::rotateAroundAxis(axisVector, (float)rotationSpeed) *
-			MeshUtility::translate(-obCenter);
+		for (size_t band = 0; band < bandCount; band++) generateBand(band);
 	}
 
-	transform(matxTrans);
+	if (useStrips) optimizeIndices(true, false);
 }
 
-void Mesh::rotateAround(Mesh * orbitingBody, glm::vec3 axisVector, double rotationSpeed)
+bool Mesh::load(const std::string& path, const bool verifyChecksum)
 {
-	rotateAround(orbitingBody->getSelfCenter(), axisVector, rotationSpeed);
+	std::shared_ptr<MeshFile> file = MeshFile::open(path, verifyChecksum);
+	if (file == nullptr) return false;
+
+	const MeshFileHeader& header = file->getHeader();
+	if (header.vertexCount >= (std::uint64_t)std::numeric_limits<int>::max()
+		|| (header.primitive != GL_TRIANGLES && header.primitive != GL_TRIANGLE_STRIP))
+	{
+		std::cerr << "ERROR: The mesh file " << path << " does not hold a mesh that can be drawn" << std::endl;
+		return false;
+	}
+
+	// Nothing is read nor copied, the blocks are sent to the GPU straight from the mapping
+	size = header.resolution;
+	nbPoints = (int)header.vertexCount;
+	freeStorage();
+	dropExternal();
+	m_externalVertices = file->getVertices();
+	m_externalIndices = file->getIndices();
+	m_file = file;
+
+	m_indexType = header.indexType;
+	m_indexSize = MeshFile::getIndexSize(header.indexType);
+	m_indexCount = (size_t)header.indexCount;
+	m_primitive = header.primitive;
+	m_restartIndex = header.restartIndex;
+	m_acmrBefore = header.acmrBefore;
+	m_acmrAfter = header.acmrAfter;
+	m_silhouetteError = header.silhouetteError;
+	return true;
 }
 
-void Mesh::move(glm::mat4 matxMove)
+bool Mesh::save(const std::string& path) const
 {
-	transform(matxMove);
+	MeshFileHeader header = {};
+	header.indexType = m_indexType;
+	header.primitive = m_primitive;
+	header.restartIndex = m_restartIndex;
+	header.resolution = (std::uint32_t)size;
+	header.vertexCount = (std::uint64_t)nbPoints;
+	header.indexCount = m_indexCount;
+	header.acmrBefore = m_acmrBefore;
+	header.acmrAfter = m_acmrAfter;
+	header.silhouetteError = m_silhouetteError;
+	return MeshFile::write(path, header, getVertexData(), getIndexData());
 }
 
-void Mesh::transform(glm::mat4 matxTrans)
+std::string Mesh::getCacheFileName(const size_t resolution, const bool useStrips, const SphereTopology topology)
 {
-	self_center = glm::vec3(matxTrans * glm::vec4{ self_center, 1 });
-
-	for (int i = 0; i < nbPoints; i++) {
-		glm::vec3 pointCoord = glm::vec3(matxTrans * glm::vec4{ m_vertexPositions[i], 1 });
-		m_vertexPositions[i] = pointCoord;
-		m_vertexNormals[i] = glm::normalize(pointCoord - self_center);
-
-		// Have a very, very slight luminous intensity drop off the further out we go
-		// Real-life has this set not at 0.375, but 2
-		// However setting that value to 2 for our model makes things look way too dark
-		// Also reminder: 1.33203125 = 10^0.125; theoretically we could do smth like pow(10/glm::length(lightVector), 0.125)
-		// But that feels like overkill for something I can manually change if needed
-		glm::vec3 lightVector = sun_center - pointCoord;
-		lightVector = 1.33203125f * glm::normalize(lightVector) / (float)pow(glm::length(lightVector), 0.125);
-
-		m_vertexLight[i] = lightVector;
+	return std::string("sphere_") + SphereGenerator::getName(topology) + "_" + std::to_string(resolution)
+		+ (useStrips ? "_strips" : "") + ".mesh";
+}
+
+void Mesh::computeStatistics()
+{
+	// The triangles as a list of 32 bits indices
+	std::vector<unsigned int> triangles(m_indexCount);
+	const void* indices = getIndexData();
+	for (size_t i = 0; i < m_indexCount; i++)
+	{
+		triangles[i] = m_indexType == GL_UNSIGNED_SHORT ? ((const GLushort*)indices)[i] : ((const GLuint*)indices)[i];
 	}
+	if (m_primitive == GL_TRIANGLE_STRIP) triangles = MeshOptimizer::unpackStrips(triangles, m_restartIndex);
 
-	glBindVertexArray(m_vao);
-	updateRendering(m_vertexPositions, &m_posVbo);
-	updateRendering(m_vertexNormals, &m_normVbo);
-	updateRendering(m_vertexLight, &m_lightVbo);
+	m_acmrAfter = MeshOptimizer::computeAcmr(triangles, nbPoints);
+	if (m_acmrBefore == kAcmrNotReordered) m_acmrBefore = m_acmrAfter;
+
+	// The mesh is convex, so its closest point to the center is on the closest triangle plane,
+	// and the view looking along that plane sees the silhouette furthest inside the sphere
+	const PackedVertex* vertices = getVertexData();
+	float closestPlane = 1.0f;
+	for (size_t i = 0; i < triangles.size(); i += 3)
+	{
+		const glm::vec3& a = vertices[triangles[i]].position;
+		const glm::vec3& b = vertices[triangles[i + 1]].position;
+		const glm::vec3& c = vertices[triangles[i + 2]].position;
+		const glm::vec3 normal = glm::cross(b - a, c - a);
+		const float length = glm::length(normal);
+		if (length == 0.0f) continue; // Degenerate, it has no plane
+
+		closestPlane = std::min(closestPlane, std::abs(glm::dot(normal, a)) / length);
+	}
+	m_silhouetteError = 1.0f - closestPlane;
+}
+
+void Mesh::selectIndexType()
+{
+	// The restart index is the largest value of the type, so it must not be a vertex
+	const bool fitsShort = nbPoints < 0xFFFF;
+	m_indexType = fitsShort ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	m_indexSize = fitsShort ? sizeof(GLushort) : sizeof(GLuint);
+	m_restartIndex = fitsShort ? 0xFFFF : 0xFFFFFFFF;
+}
+
+void Mesh::optimizeIndices(const bool useStrips, const bool reorder)
+{
+	// The triangles are only measured as generated here, the rest is up to computeStatistics()
+	m_acmrBefore = MeshOptimizer::computeAcmr(m_triangleIndices, nbPoints);
+	if (reorder) MeshOptimizer::optimizeVertexCache(m_triangleIndices, nbPoints);
+
+	selectIndexType();
+	const bool fitsShort = m_indexType == GL_UNSIGNED_SHORT;
+
+	if (useStrips)
+	{
+		m_primitive = GL_TRIANGLE_STRIP;
+		m_triangleIndices = MeshOptimizer::buildStrips(m_triangleIndices, m_restartIndex);
+	}
+	else
+	{
+		m_primitive = GL_TRIANGLES;
+	}
+
+	// Right after the vertices, in the room allocateVertices() left
+	m_indexCount = m_triangleIndices.size();
+	m_indices = m_arena.allocateArray<unsigned char>(m_indexCount * m_indexSize);
+	if (fitsShort)
+	{
+		GLushort* shortIndices = (GLushort*)m_indices;
+		for (size_t i = 0; i < m_indexCount; i++) shortIndices[i] = (GLushort)m_triangleIndices[i];
+	}
+	else
+	{
+		std::memcpy(m_indices, m_triangleIndices.data(), m_indexCount * m_indexSize);
+	}
+
+	// Free the generation indices
+	std::vector<unsigned int>().swap(m_triangleIndices);
+}
+
+void Mesh::renderMesh()
+{
+	if (m_instanceCount == 0) return;
+
+	if (m_primitive == GL_TRIANGLE_STRIP)
+	{
+		glEnable(GL_PRIMITIVE_RESTART);
+		glPrimitiveRestartIndex(m_restartIndex);
+	}
+
+	glBindVertexArray(m_vao);     // activate the VAO storing geometry data
+	glDrawElementsInstanced(m_primitive, (GLsizei)m_indexCount, m_indexType, 0, m_instanceCount);
 	glBindVertexArray(0); // Unbinding
+
+	if (m_primitive == GL_TRIANGLE_STRIP) glDisable(GL_PRIMITIVE_RESTART);
+
+	m_instanceStream.fence(); // The instance region can be rewritten once this draw is done
 }
 
-glm::vec3 Mesh::getSelfCenter() const
+void Mesh::renderPatches()
 {
-	return self_center;
+	assert(m_primitive == GL_TRIANGLES);
+	if (m_instanceCount == 0) return;
+
+	GLExtensions::patchParameteri(GL_PATCH_VERTICES, 3);
+
+	glBindVertexArray(m_vao);
+	glDrawElementsInstanced(GL_PATCHES, (GLsizei)m_indexCount, m_indexType, 0, m_instanceCount);
+	glBindVertexArray(0); // Unbinding
+
+	m_instanceStream.fence(); // The instance region can be rewritten once this draw is done
 }
\ No newline at end of file
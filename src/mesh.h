@@ -1,7 +1,13 @@
 #ifndef INCLUDE_MESH
 #define INCLUDE_MESH
 
+#include "arena.h"
+#include "dirtyRanges.h"
+#include "meshFile.h"
 #include "meshUtility.h"
+#include "sphereGenerator.h"
+#include "streamBuffer.h"
+#include "threadPool.h"
 
 #include <dep/glm/glm.hpp>
 #include <dep/glm/gtc/matrix_transform.hpp>
@@ -10,132 +16,281 @@
 #include <iostream>
 #include <glad/gl.h>
 #include <memory>
+#include <string>
 #include <vector>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
 #include <corecrt_math_defines.h>
 
+/*
+* @brief Per-instance data sent to vertexShader.glsl, one per body drawn with a Mesh.
+*/
+struct MeshInstance
+{
+	glm::mat4 modelMatrix; // Local to world transformation of the body
+	float textureLayer;    // Layer of the body texture array
+	float emissive;        // 1 if the body emits its own light (the sun), 0 otherwise
+};
+
+/*
+* @brief Immutable sphere geometry, uploaded once to the GPU and shared between all the bodies using it.
+* 
+* The per-body state (placement, axial tilt, ...) lives in Body, which only holds a reference to its Mesh.
+*/
 class Mesh
 {
 public:
+	Mesh() = default;
+
+	// Copying would duplicate the GL objects' ownership, share the Mesh through a std::shared_ptr instead
+	Mesh(const Mesh&) = delete;
+	Mesh& operator=(const Mesh&) = delete;
+
+	/*
+	* @brief Frees the GPU buffers, if they were created.
+	*/
+	~Mesh();
+
 	/*
-	* @brief Declares the different vectors that store the Mesh information, and then creates the mesh.
+	* @brief Creates the mesh, using the one baked into the binary if there is one, then the one of the cache directory,
+	* and generating it otherwise, in which case it is saved to the cache directory.
 	* 
-	* @param resolution The amount of points used to approximate a disk, and also amount of disks.
+	* @param resolution The amount of points used to approximate a disk, and also amount of disks. See SphereTopology for the other topologies.
+	* @param useStrips Whether to store triangle strips separated by primitive restarts instead of a triangle list.
+	* @param topology How the sphere is cut into triangles.
+	* @param threadPool The workers generating the mesh, if it is not baked, nullptr to generate it on the calling thread.
+	* @param cacheDirectory The directory of the mesh files, created if needed, ending with a separator. Empty to not use any.
 	*/
-	void init(const size_t resolution);
+	void init(const size_t resolution, const bool useStrips = false, const SphereTopology topology = UVSphere, ThreadPool* threadPool = nullptr,
+		const std::string& cacheDirectory = "");
 
 	/*
-	* @brief Sets up the sun-specific parameters.
+	* @brief Declares the different vectors that store the Mesh information, and then generates the mesh, even if it is baked.
+	* 
+	* The triangles are in vertex cache order, and stored with the narrowest index type.
+	* The latitude bands of the UV spheres are independent, and spread over the workers if there are some.
+	* 
+	* @param resolution The amount of points used to approximate a disk, and also amount of disks. See SphereTopology for the other topologies.
+	* @param useStrips Whether to store triangle strips separated by primitive restarts instead of a triangle list.
+	* @param topology How the sphere is cut into triangles.
+	* @param threadPool The workers generating the UV sphere triangle lists, nullptr to generate on the calling thread.
+	*/
+	void generate(const size_t resolution, const bool useStrips = false, const SphereTopology topology = UVSphere, ThreadPool* threadPool = nullptr);
+
+	/*
+	* @brief Uses a mesh file in place, mapped in memory: nothing is read until it is used.
+	* 
+	* @param path The mesh file, written by save().
+	* @param verifyChecksum Whether to check the whole file first.
+	* 
+	* @return Whether the file is valid. If not, the mesh is left untouched.
 	*/
-	void setupSun();
+	bool load(const std::string& path, const bool verifyChecksum = true);
 
 	/*
-	* @brief Sets up the planet-specific parameters
+	* @brief Writes the mesh to a mesh file, with its statistics.
+	* 
+	* @param path Where to write the file.
 	* 
-	* @param angleOfRotationAxis The angle at which the planet rotates around.
-	* @param orbitProgress The offset in radians of how far into its orbit the body is.
-	* @param orbitInclination The angle, relative to Earth's of its orbit around the sun.
+	* @return Whether the file could be written.
+	*/
+	bool save(const std::string& path) const;
+
+	/*
+	* @brief Get the name of the cache file of a generated sphere, the same for every build using the same MeshFile::kVersion.
+	*/
+	static std::string getCacheFileName(const size_t resolution, const bool useStrips, const SphereTopology topology);
+
+	/*
+	* @brief Measures the mesh for getAcmrBefore(), getAcmrAfter() and getSilhouetteError(), which are 0 until then.
 	*/
-	void setupPlanet(double angleOfRotationAxis, double orbitProgress, double orbitInclination);
+	void computeStatistics();
 
 	/*
 	* @brief Function called during the main rendering loop
+	* 
+	* Draws every instance written between mapInstances() and unmapInstances() with a single instanced draw call.
 	*/
 	void renderMesh();
 
 	/*
-	* @brief Rotate around a body.
+	* @brief Same as renderMesh(), each triangle being a patch to refine by the tessellation shaders.
+	* Requires a triangle list, and GLExtensions::hasTessellation().
+	*/
+	void renderPatches();
+
+	/*
+	* @brief Gives direct access to the GPU memory of the instances drawn by renderMesh(), replacing the previous ones.
 	* 
-	* Note that this rotation is both around the orbitingBody and the body itself.
+	* @param count The amount of instances to draw, one per body.
 	* 
-	* @param orbitingBody The pointer to the body the current body is orbiting around
-	* @param axisVector The axis to spin around
-	* @param rotationSpeed The speed of rotation around the body
+	* @return Where to write the count instances, valid until unmapInstances().
 	*/
-	void rotateAround(Mesh* orbitingBody, glm::vec3 axisVector, double rotationSpeed);
+	MeshInstance* mapInstances(size_t count);
 
 	/*
-	* @brief Rotate around a body.
-	*
-	* Note that this rotation is both around the orbitingBody and the body itself.
-	*
-	* @param obCenter The coordinates of the center of the body the current body is orbiting around.
-	* @param axisVector The axis to spin around
-	* @param rotationSpeed The speed of rotation around the body
+	* @brief Hands the instances written since mapInstances() to the GPU.
 	*/
-	void rotateAround(glm::vec3 obCenter, glm::vec3 axisVector, double rotationSpeed);
+	void unmapInstances();
 
 	/*
-	* @brief Move a body linearly.
+	* @brief Gives write access to a part of the vertices, which will be sent by uploadEdits().
 	* 
-	* @param matxMove The transformation matrix describing how to move the body
+	* @param first The first vertex to modify.
+	* @param count The amount of vertices to modify.
+	* 
+	* @return The first of the count vertices to modify, valid until the next init().
+	*/
+	PackedVertex* editVertices(size_t first, size_t count);
+
+	/*
+	* @brief Gives write access to a part of the indices, which will be sent by uploadEdits().
+	* 
+	* @param first The first index to modify.
+	* @param count The amount of indices to modify.
+	* 
+	* @return The first of the count indices to modify, of the type given by getIndexType(), valid until the next init().
+	*/
+	void* editIndices(size_t first, size_t count);
+
+	/*
+	* @brief Get the type of the indices, GL_UNSIGNED_SHORT when every vertex can be addressed with 16 bits, GL_UNSIGNED_INT otherwise.
+	*/
+	inline GLenum getIndexType() const { return m_indexType; }
+
+	/*
+	* @brief Get the amount of indices, primitive restarts included.
+	*/
+	inline size_t getIndexCount() const { return m_indexCount; }
+
+	/*
+	* @brief Get the amount of vertices, the ones duplicated along the texture seams included.
+	*/
+	inline size_t getVertexCount() const { return (size_t)nbPoints; }
+
+	/*
+	* @brief Get the vertices, getVertexCount() of them.
+	*/
+	inline const PackedVertex* getVertexData() const { return m_externalVertices != nullptr ? m_externalVertices : m_vertices; }
+
+	/*
+	* @brief Get the indices, getIndexCount() of them, of the type given by getIndexType().
+	*/
+	inline const void* getIndexData() const { return m_externalIndices != nullptr ? m_externalIndices : (const void*)m_indices; }
+
+	/*
+	* @brief Get the storage of the generated vertices and indices, to measure it.
+	*/
+	inline const Arena& getArena() const { return m_arena; }
+
+	/*
+	* @brief Get the largest gap between the unit sphere and the mesh, the worst silhouette error from any view, in sphere radii.
 	*/
-	void move(glm::mat4 matxMove);
+	inline float getSilhouetteError() const { return m_silhouetteError; }
+
+	/*
+	* @brief Get the average cache miss ratio (vertices transformed per triangle) of the triangles as generated.
+	*/
+	inline float getAcmrBefore() const { return m_acmrBefore; }
+
+	/*
+	* @brief Get the average cache miss ratio of the triangles as sent to the GPU.
+	*/
+	inline float getAcmrAfter() const { return m_acmrAfter; }
+
+	/*
+	* @brief Sends to the GPU the parts of the vertices and indices modified since the last call, and only those.
+	*/
+	void uploadEdits();
+
+	/*
+	* @brief Get the amount of bytes the next uploadEdits() will send, the modified ranges merged as DirtyRanges does.
+	*/
+	size_t getPendingEditBytes() const;
 
 	/*
 	* @brief Defines how the mesh will be displayed on screen.
 	*/
 	void defineRenderMethod();
 
+	/*
+	* @brief Declares the layout of PackedVertex to vertexShader.glsl.
+	* The VAO must be bound, and the vertex buffer bound to GL_ARRAY_BUFFER.
+	*/
+	static void defineVertexAttributes();
+
 	/**
-	* @brief Generates a sphere centered at (0,0,0) with sphereRadius 1 and sets the position of the sun.
+	* @brief Generates a sphere centered at (0,0,0) with sphereRadius 1.
 	*
-	* @param x The x-coordinate of the sun.
-	* @param y The y-coordinate of the sun.
-	* @param z The z-coordinate of the sun.
 	* @param resolution The amount of points used to approximate a disk, and also amount of disks. Defaults to 16.
+	* @param useStrips Whether to draw the sphere as triangle strips instead of a triangle list.
+	* @param topology How the sphere is cut into triangles, a latitude/longitude grid by default.
+	* @param threadPool The workers sharing the generation of a latitude/longitude grid, nullptr to generate it on the calling thread.
+	* @param cacheDirectory The directory the generated spheres are saved to and loaded from, empty to not use any.
 	*
 	* @return The initialized Mesh
 	*/
-	inline static std::shared_ptr<Mesh> genSphere(float x, float y, float z, const size_t resolution = 16)
+	inline static std::shared_ptr<Mesh> genSphere(const size_t resolution = 16, const bool useStrips = false, const SphereTopology topology = UVSphere,
+		ThreadPool* threadPool = nullptr, const std::string& cacheDirectory = "")
 	{
-		// This method is only called once to create a sphere, then rendered three times in different positions
-		// With translations
+		// This method is only called once to create a sphere, then every body refers to it
+		// and is placed with its own model matrix
 
 		// Shared pointer used to auto free the pointer when no longer used
 		std::shared_ptr<Mesh> sharedMeshPointer = std::make_shared<Mesh>();
-		sharedMeshPointer->init(resolution);
-		sharedMeshPointer->setSunCenter(x, y, z);
+		sharedMeshPointer->init(resolution, useStrips, topology, threadPool, cacheDirectory);
 		return sharedMeshPointer;
 	}
 
-	/*
-	* @brief Get the center of the body.
-	* 
-	* @return The coordinate of the center of the body.
-	*/
-	glm::vec3 getSelfCenter() const;
-
 private:
-	// The position of the vertices, not the triangles
-	std::vector<glm::vec3> m_vertexPositions;
+	// Holds m_vertices then m_indices, in a single block, each aligned on a cache line
+	// Everything is freed at once when the mesh is generated again or destroyed
+	Arena m_arena{ 0 };
+
+	// The position, normal and texture coordinates of the vertices, not the triangles
+	// These are in local space and never modified after init(), each Body places them with its model matrix
+	PackedVertex* m_vertices = nullptr;
 
-	// The color at the vertices, not the global color of the triangle
-	std::vector<glm::vec3> m_vertexNormals;
-	std::vector<glm::vec3> m_vertexLight;
-	std::vector<glm::vec3> m_vertexAmbience;
-	std::vector<glm::vec2> m_vertexTexCoords;
+	// The vertices and indices baked into the binary or of m_file, used in place of m_vertices and m_indices until they are edited
+	const PackedVertex* m_externalVertices = nullptr;
+	const void* m_externalIndices = nullptr;
+	std::shared_ptr<MeshFile> m_file;
 
+	// Only used while generating the mesh, the GPU indices are in m_indices
 	std::vector<unsigned int> m_triangleIndices;
+
+	// The indices as sent to the GPU, of type m_indexType
+	unsigned char* m_indices = nullptr;
+	GLenum m_indexType = GL_UNSIGNED_INT;
+	size_t m_indexSize = sizeof(GLuint);
+	size_t m_indexCount = 0;
+
+	// GL_TRIANGLE_STRIP primitives are separated by m_restartIndex
+	GLenum m_primitive = GL_TRIANGLES;
+	GLuint m_restartIndex = 0;
+
+	// m_acmrBefore is only measured before the triangles are transformed, otherwise it is m_acmrAfter
+	static constexpr float kAcmrNotReordered = -1.0f;
+	float m_acmrBefore = 0.0f, m_acmrAfter = 0.0f;
+	float m_silhouetteError = 0.0f;
 	GLuint m_vao = 0;
 
-	GLuint m_posVbo = 0;
-	GLuint m_normVbo = 0;
-	GLuint m_lightVbo = 0;
-	GLuint m_ambiVbo = 0;
-	GLuint m_texVbo = 0;
+	GLuint m_vbo = 0;
 
 	GLuint m_ibo = 0;
 
-	// Coordinates of the sun
-	glm::vec3 sun_center{ glm::vec3(0.0f) }, self_center{ glm::vec3(0.0f) };
+	// Rewritten every frame, hence streamed
+	StreamBuffer m_instanceStream;
+	GLsizei m_instanceCount = 0;
+
+	// Parts of m_vertices and m_indices modified since they were sent to the GPU
+	DirtyRanges m_dirtyVertices, m_dirtyIndices;
 
 	// Amount of points used to approximate a disk, and also amount of disks.
 	size_t size = 16;
 	int nbPoints=0;
 
-	double rotationalAxis = 0.0f;
-
 	/**
 	* @brief Defines a point's position given its x,y,z coordinates.
 	*
@@ -146,16 +301,6 @@ private:
 	*/
 	void definePointPosition(int position, float x, float y, float z);
 
-	/**
-	* @brief Defines a triangle's vertexes.
-	*
-	* @param position The triangle to assign the vertexes to.
-	* @param pt1 The triangle's first point.
-	* @param pt2 The triangle's second point.
-	* @param pt3 The triangle's third point.
-	*/
-	void defineTrianglePoints(int position, int pt1, int pt2, int pt3);
-
 	/**
 	* @brief Defines how to map the textures to the vertices.
 	*
@@ -165,62 +310,73 @@ private:
 	*/
 	void defineTextureCoord(int position, float x, float y);
 
-	/**
-	* @brief Sets up the position of the points in the mesh
+	/*
+	* @brief Defines the vertices and triangles of the topologies generated by SphereGenerator.
 	*/
-	void definePositions();
+	void defineGeneratedSphere(const SphereTopology topology);
 
-	/**
-	* @brief Associates the texture to the vertex
+	/*
+	* @brief Picks the narrowest index type, and the matching primitive restart index.
+	*/
+	void selectIndexType();
+
+	/*
+	* @brief Frees the previous vertices and indices, and allocates the vertices, with room for the indices right after them.
+	* 
+	* @param vertexCount The amount of vertices.
+	* @param indexBytes The largest size the indices may have.
 	*/
-	void defineTextureCoords();
+	void allocateVertices(size_t vertexCount, size_t indexBytes);
 
 	/*
-	* @brief Defines the triangles by defining their points.
+	* @brief Frees the vertices and indices, the ones used in place being kept.
 	*/
-	void defineIndices();
+	void freeStorage();
+
+	/*
+	* @brief Copies the vertices and indices used in place, to modify them.
+	*/
+	void detachExternal();
+
+	/*
+	* @brief Stops using the vertices and indices in place, to replace them.
+	*/
+	void dropExternal();
+
+	/*
+	* @brief Reorders the generated triangles for the vertex cache, and narrows them in m_indices.
+	* 
+	* @param useStrips Whether to convert the triangles to strips.
+	* @param reorder Whether the triangles need to be reordered, they may have been generated in a cache friendly order.
+	*/
+	void optimizeIndices(const bool useStrips, const bool reorder);
 
 	
 	/**
 	 * @brief Sends vertex data to the GPU for use in a vertex shader.
 	 *
-	 * This function generates a Vertex Buffer Object (VBO) and uploads vertex information
-	 * from a CPU-side vector to the GPU. It sets up the vertex attribute pointer to specify
-	 * how the vertex data should be interpreted by the vertex shader.
+	 * This function generates a Vertex Buffer Object (VBO) and uploads the interleaved vertices
+	 * from CPU memory to the GPU. It sets up the vertex attribute pointers to specify
+	 * how each field of PackedVertex should be interpreted by the vertex shader.
 	 *
-	 * @tparam T The type of the vertex data.
-	 * @param m_vertexInfo A vector containing the vertex information to be sent to the GPU.
+	 * @param vertices The vertices to be sent to the GPU.
+	 * @param count The amount of vertices.
 	 * @param vbo A pointer to an GLuint where the generated VBO ID will be stored.
-	 * @param location The index of the vertex attribute in the shader that will receive
-	 *                 this data.
 	 */
-	template <typename T>
-	void sendVertexShader(std::vector<T> m_vextexInfo, GLuint *vbo, int location);
+	void sendVertexShader(const PackedVertex* vertices, size_t count, GLuint *vbo);
 
 	/*
-	* @brief Update the data being sent to vertexShader.glsl
-	* 
-	* @param m_vertexInfo The data replacing the old data being sent to the vertex shader.
-	* @param vbo The pointer associated with the location transmitting the old data.
+	* @brief Declares the per-instance attributes to vertexShader.glsl.
+	* The VAO must be bound.
 	*/
-	void updateRendering(std::vector<glm::vec3> m_vextexInfo, GLuint *vbo);
+	void defineInstanceAttributes();
 
 	/*
-	* @brief Set the coordinates of the location of the sun's center.
-	* This function is private because it should only be accessed by genSphere()
-	*/
-	inline void setSunCenter(float x, float y, float z)
-	{
-		sun_center = glm::vec3(x, y, z);
-	}
-
-	/*
-	* @brief A general purpose function for applying (or creating) a transformation matrix.
-	* 
-	* This function serves to either apply a translation matrix, or apply a rotation matrix around an axis.
+	* @brief Points the per-instance attributes to the region of the instance stream holding this frame's instances.
+	* The VAO and the instance stream must be bound.
 	* 
-	* @param matxTrans The transformation matrix describing how to move the body
+	* @param offset The offset of the region in the instance stream.
 	*/
-	void transform(glm::mat4 matxTrans);
+	void bindInstanceAttributes(GLintptr offset);
 };
 #endif
\ No newline at end of file
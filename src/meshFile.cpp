@@ -0,0 +1,213 @@
+#include "meshFile.h"
+
+#include <glad/gl.h>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static_assert(sizeof(MeshFileHeader) == 88, "The header layout is part of the file format, change kVersion with it");
+
+// Rounds up to the next multiple of MeshFile::kAlignment
+static std::uint64_t align(std::uint64_t offset)
+{
+	return (offset + MeshFile::kAlignment - 1) / MeshFile::kAlignment * MeshFile::kAlignment;
+}
+
+// Whether every index addresses a vertex, the primitive restarts of the strips aside
+template <typename Index>
+static bool areIndicesInRange(const Index* indices, std::uint64_t count, std::uint64_t vertexCount, std::uint64_t restartIndex)
+{
+	// The largest index, the restarts counted as 0, without any branch so that the loop vectorizes
+	const Index restart = (Index)restartIndex;
+	Index maxIndex = 0;
+	for (std::uint64_t i = 0; i < count; i++) maxIndex = std::max(maxIndex, indices[i] != restart ? indices[i] : (Index)0);
+	return count == 0 || maxIndex < vertexCount;
+}
+
+static bool areIndicesInRange(const MeshFileHeader& header, const void* indices)
+{
+	// A list has no restart, and counting its 0 indices as 0 changes nothing
+	const std::uint64_t restartIndex = header.primitive == GL_TRIANGLE_STRIP ? header.restartIndex : 0;
+	return header.indexType == GL_UNSIGNED_SHORT
+		? areIndicesInRange((const GLushort*)indices, header.indexCount, header.vertexCount, restartIndex)
+		: areIndicesInRange((const GLuint*)indices, header.indexCount, header.vertexCount, restartIndex);
+}
+
+size_t MeshFile::getIndexSize(std::uint32_t indexType)
+{
+	switch (indexType)
+	{
+	case GL_UNSIGNED_SHORT: return sizeof(GLushort);
+	case GL_UNSIGNED_INT: return sizeof(GLuint);
+	}
+	return 0;
+}
+
+std::uint64_t MeshFile::checksum(const void* data, size_t bytes, std::uint64_t seed)
+{
+	// FNV-1a over 64 bits words, rotated so that the high bits also reach the low ones
+	// The four lanes do not depend on each other, so their multiplications overlap
+	const std::uint64_t kPrime = 0x100000001B3ull;
+	std::uint64_t lanes[4] = { seed ^ 0xCBF29CE484222325ull, seed + 1, seed + 2, seed + 3 };
+	auto mix = [&](std::uint64_t& lane, std::uint64_t word) {
+		lane = (lane ^ word) * kPrime;
+		lane = (lane << 31) | (lane >> 33);
+	};
+
+	const unsigned char* bytePointer = (const unsigned char*)data;
+	size_t i = 0;
+	for (; i + 32 <= bytes; i += 32)
+	{
+		std::uint64_t words[4];
+		std::memcpy(words, bytePointer + i, sizeof(words)); // The blocks are aligned, but not every caller's
+		for (int lane = 0; lane < 4; lane++) mix(lanes[lane], words[lane]);
+	}
+
+	// The tail, zero padded to a word
+	for (int lane = 0; i < bytes; i += 8, lane++)
+	{
+		std::uint64_t word = 0;
+		std::memcpy(&word, bytePointer + i, bytes - i < 8 ? bytes - i : 8);
+		mix(lanes[lane], word);
+	}
+
+	std::uint64_t hash = bytes;
+	for (int lane = 0; lane < 4; lane++) mix(hash, lanes[lane]);
+	return hash;
+}
+
+bool MeshFile::write(const std::string& path, MeshFileHeader header, const PackedVertex* vertices, const void* indices)
+{
+	const std::uint64_t vertexBytes = header.vertexCount * sizeof(PackedVertex);
+	const std::uint64_t indexBytes = header.indexCount * getIndexSize(header.indexType);
+
+	std::memcpy(header.magic, kMagic, sizeof(kMagic));
+	header.version = kVersion;
+	header.vertexSize = sizeof(PackedVertex);
+	header.vertexOffset = align(sizeof(MeshFileHeader));
+	header.indexOffset = align(header.vertexOffset + vertexBytes);
+	header.checksum = checksum(indices, indexBytes, checksum(vertices, vertexBytes));
+	header.reserved = 0;
+
+	// Written aside then renamed, so that a crash never leaves half a file
+	const std::string temporaryPath = path + ".tmp";
+	std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+	const char padding[kAlignment] = {};
+	file.write((const char*)&header, sizeof(header));
+	file.write(padding, header.vertexOffset - sizeof(header));
+	file.write((const char*)vertices, vertexBytes);
+	file.write(padding, header.indexOffset - header.vertexOffset - vertexBytes);
+	file.write((const char*)indices, indexBytes);
+	file.write(padding, align(header.indexOffset + indexBytes) - header.indexOffset - indexBytes);
+	file.close();
+
+	std::error_code error;
+	if (file) std::filesystem::rename(temporaryPath, path, error);
+	if (!file || error)
+	{
+		std::filesystem::remove(temporaryPath, error);
+		std::cerr << "ERROR: Failed to write the mesh file " << path << std::endl;
+		return false;
+	}
+	return true;
+}
+
+std::shared_ptr<MeshFile> MeshFile::open(const std::string& path, bool verifyChecksum)
+{
+	std::shared_ptr<MeshFile> meshFile(new MeshFile());
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE) return nullptr;
+
+	LARGE_INTEGER fileSize;
+	if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart >= (LONGLONG)sizeof(MeshFileHeader))
+	{
+		// The view keeps the mapping, which keeps the file, open on its own
+		HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mapping != NULL)
+		{
+			meshFile->m_data = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			meshFile->m_size = (size_t)fileSize.QuadPart;
+			CloseHandle(mapping);
+		}
+	}
+	CloseHandle(file);
+#else
+	const int file = ::open(path.c_str(), O_RDONLY);
+	if (file < 0) return nullptr;
+
+	struct stat fileStat;
+	if (fstat(file, &fileStat) == 0 && fileStat.st_size >= (off_t)sizeof(MeshFileHeader))
+	{
+		// The mapping keeps the file open on its own
+		void* data = mmap(nullptr, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+		if (data != MAP_FAILED)
+		{
+			meshFile->m_data = (const unsigned char*)data;
+			meshFile->m_size = (size_t)fileStat.st_size;
+		}
+	}
+	close(file);
+#endif
+
+	if (meshFile->m_data == nullptr)
+	{
+		std::cerr << "ERROR: Failed to map the mesh file " << path << std::endl;
+		return nullptr;
+	}
+
+	// A file from another build is expected, and is simply not used
+	const MeshFileHeader& header = meshFile->getHeader();
+	if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion || header.vertexSize != sizeof(PackedVertex))
+	{
+		return nullptr;
+	}
+
+	// The counts are checked one at a time so that no product overflows
+	const size_t indexSize = getIndexSize(header.indexType);
+	const std::uint64_t size = meshFile->m_size;
+	const bool valid = indexSize != 0
+		&& header.vertexOffset % kAlignment == 0 && header.indexOffset % kAlignment == 0
+		&& header.vertexOffset >= sizeof(MeshFileHeader) && header.vertexOffset <= size
+		&& header.vertexCount <= (size - header.vertexOffset) / sizeof(PackedVertex)
+		&& header.indexOffset >= header.vertexOffset + header.vertexCount * sizeof(PackedVertex) && header.indexOffset <= size
+		&& header.indexCount <= (size - header.indexOffset) / indexSize
+		&& (header.primitive == GL_TRIANGLES || header.primitive == GL_TRIANGLE_STRIP)
+		&& (verifyChecksum
+			? header.checksum == checksum(meshFile->getIndices(), header.indexCount * indexSize,
+				checksum(meshFile->getVertices(), header.vertexCount * sizeof(PackedVertex)))
+			: areIndicesInRange(header, meshFile->getIndices()));
+	if (!valid)
+	{
+		std::cerr << "ERROR: The mesh file " << path << " is truncated or corrupted" << std::endl;
+		return nullptr;
+	}
+
+	return meshFile;
+}
+
+MeshFile::~MeshFile()
+{
+	if (m_data == nullptr) return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(m_data);
+#else
+	munmap((void*)m_data, m_size);
+#endif
+}
@@ -0,0 +1,108 @@
+#ifndef INCLUDE_MESHFILE
+#define INCLUDE_MESHFILE
+
+#include "meshUtility.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/*
+* @brief Beginning of a mesh file, followed by the vertex block and the index block.
+*
+* The file is written in the native byte order and PackedVertex layout, the version and vertexSize
+* reject the files written by another build.
+*/
+struct MeshFileHeader
+{
+	char magic[8];               // MeshFile::kMagic
+	std::uint32_t version;       // MeshFile::kVersion
+	std::uint32_t vertexSize;    // sizeof(PackedVertex)
+	std::uint32_t indexType;     // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+	std::uint32_t primitive;     // GL_TRIANGLES or GL_TRIANGLE_STRIP
+	std::uint32_t restartIndex;  // Separates the strips of GL_TRIANGLE_STRIP
+	std::uint32_t resolution;    // The resolution the mesh was generated with, 0 if not generated
+	std::uint64_t vertexCount;
+	std::uint64_t indexCount;
+	std::uint64_t vertexOffset;  // From the beginning of the file, a multiple of MeshFile::kAlignment
+	std::uint64_t indexOffset;   // Idem
+	std::uint64_t checksum;      // MeshFile::checksum() of the vertex block, then of the index block
+	float acmrBefore, acmrAfter; // See Mesh::getAcmrBefore() and Mesh::getAcmrAfter()
+	float silhouetteError;       // See Mesh::getSilhouetteError()
+	std::uint32_t reserved;      // 0
+};
+
+/*
+* @brief Mesh stored on disk, mapped in memory so that its blocks can be sent to the GPU without being read nor copied first.
+*
+* The blocks are aligned on cache lines. The mapping lasts as long as the MeshFile.
+*/
+class MeshFile
+{
+public:
+	static constexpr char kMagic[8] = { 't', 'p', 'M', 'e', 's', 'h', '\r', '\n' };
+	static constexpr std::uint32_t kVersion = 1;
+	static constexpr size_t kAlignment = 64;
+
+	MeshFile(const MeshFile&) = delete;
+	MeshFile& operator=(const MeshFile&) = delete;
+
+	/*
+	* @brief Unmaps the file.
+	*/
+	~MeshFile();
+
+	/*
+	* @brief Writes a mesh file, replacing any previous one.
+	*
+	* Windows does not replace a file that is mapped: the MeshFile opened on it, and the meshes loaded from it,
+	* must be released first. Otherwise the write fails and the previous file is left as it was.
+	*
+	* @param path Where to write the file.
+	* @param header The description of the mesh. The magic, version, vertexSize, offsets and checksum are filled in.
+	* @param vertices The header.vertexCount vertices.
+	* @param indices The header.indexCount indices, of type header.indexType.
+	*
+	* @return Whether the whole file could be written.
+	*/
+	static bool write(const std::string& path, MeshFileHeader header, const PackedVertex* vertices, const void* indices);
+
+	/*
+	* @brief Maps a mesh file in memory and checks it.
+	*
+	* @param path The file to open.
+	* @param verifyChecksum Whether to check the blocks against the checksum, which reads the whole file.
+	* Otherwise only the header and the index block are read: every index must address a vertex of the file,
+	* so that a corrupted file cannot make the GPU read past the vertices. The vertex pages are read as they are used.
+	*
+	* @return The mapped file, nullptr if it is missing, truncated, corrupted or from another version.
+	*/
+	static std::shared_ptr<MeshFile> open(const std::string& path, bool verifyChecksum = true);
+
+	/*
+	* @brief Hashes a block, 64 bits at a time in four independent lanes. Catches corruptions, not tampering.
+	*
+	* @param data The block.
+	* @param bytes The size of the block.
+	* @param seed The checksum of the previous block, to chain them.
+	*/
+	static std::uint64_t checksum(const void* data, size_t bytes, std::uint64_t seed = 0);
+
+	inline const MeshFileHeader& getHeader() const { return *(const MeshFileHeader*)m_data; }
+	inline const PackedVertex* getVertices() const { return (const PackedVertex*)(m_data + getHeader().vertexOffset); }
+	inline const void* getIndices() const { return m_data + getHeader().indexOffset; }
+
+	/*
+	* @brief Get the size of the index type of a header, 0 if it is not a valid index type.
+	*/
+	static size_t getIndexSize(std::uint32_t indexType);
+
+private:
+	const unsigned char* m_data = nullptr;
+	size_t m_size = 0;
+
+	MeshFile() = default;
+};
+
+#endif
@@ -0,0 +1,258 @@
+#include "meshOptimizer.h"
+
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+
+float MeshOptimizer::computeAcmr(const std::vector<unsigned int>& indices, size_t vertexCount, int cacheSize)
+{
+	if (indices.empty()) return 0.0f;
+
+	// The time at which each vertex entered the cache, it is still there while less than cacheSize misses happened since
+	std::vector<size_t> entryTime(vertexCount, 0);
+	size_t misses = 0;
+	for (unsigned int index : indices)
+	{
+		if (entryTime[index] == 0 || misses - entryTime[index] >= (size_t)cacheSize)
+		{
+			misses++;
+			entryTime[index] = misses; // Shifted by one, 0 means never seen
+		}
+	}
+	return (float)misses / (indices.size() / 3);
+}
+
+namespace
+{
+	// Tom Forsyth, "Linear-Speed Vertex Cache Optimisation", 2006
+	const int kForsythCacheSize = 32;
+
+	float forsythVertexScore(int cachePosition, unsigned int remainingValence)
+	{
+		if (remainingValence == 0) return -1.0f; // Not used by any triangle left
+
+		float score = 0.0f;
+		if (cachePosition >= 0)
+		{
+			// The vertices of the last triangle get a fixed score, so that its neighbours are not favoured over each other
+			if (cachePosition < 3) score = 0.75f;
+			else score = std::pow(1.0f - (cachePosition - 3) / (float)(kForsythCacheSize - 3), 1.5f);
+		}
+
+		// Favour the vertices with few triangles left, so that no lonely triangle is left behind
+		score += 2.0f / std::sqrt((float)remainingValence);
+		return score;
+	}
+}
+
+void MeshOptimizer::optimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount)
+{
+	const size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0) return;
+
+	// Triangles using each vertex, packed; the first remainingValence ones are the triangles not emitted yet
+	std::vector<unsigned int> firstTriangle(vertexCount + 1, 0), remainingValence(vertexCount, 0);
+	for (unsigned int index : indices) remainingValence[index]++;
+	for (size_t v = 0; v < vertexCount; v++) firstTriangle[v + 1] = firstTriangle[v] + remainingValence[v];
+
+	std::vector<unsigned int> vertexTriangles(indices.size());
+	std::vector<unsigned int> filled(vertexCount, 0);
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		for (int corner = 0; corner < 3; corner++)
+		{
+			const unsigned int v = indices[t * 3 + corner];
+			vertexTriangles[firstTriangle[v] + filled[v]++] = (unsigned int)t;
+		}
+	}
+
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> vertexScore(vertexCount);
+	for (size_t v = 0; v < vertexCount; v++) vertexScore[v] = forsythVertexScore(-1, remainingValence[v]);
+
+	std::vector<bool> emitted(triangleCount, false);
+
+	std::vector<unsigned int> optimized;
+	optimized.reserve(indices.size());
+
+	std::vector<unsigned int> cache, newCache;
+	cache.reserve(kForsythCacheSize + 3);
+	newCache.reserve(kForsythCacheSize + 3);
+
+	size_t nextUnemitted = 0;
+	long long bestTriangle = -1;
+	for (size_t emittedCount = 0; emittedCount < triangleCount; emittedCount++)
+	{
+		if (bestTriangle < 0)
+		{
+			// No triangle left around the cache, start again from the first one not emitted
+			while (emitted[nextUnemitted]) nextUnemitted++;
+			bestTriangle = (long long)nextUnemitted;
+		}
+
+		const size_t t = (size_t)bestTriangle;
+		emitted[t] = true;
+		newCache.clear();
+		for (int corner = 0; corner < 3; corner++)
+		{
+			const unsigned int v = indices[t * 3 + corner];
+			optimized.push_back(v);
+			newCache.push_back(v);
+
+			// Move the triangle past the remaining ones of the vertex
+			unsigned int* triangles = &vertexTriangles[firstTriangle[v]];
+			for (unsigned int i = 0; i < remainingValence[v]; i++)
+			{
+				if (triangles[i] == t)
+				{
+					triangles[i] = triangles[remainingValence[v] - 1];
+					triangles[remainingValence[v] - 1] = (unsigned int)t;
+					break;
+				}
+			}
+			remainingValence[v]--;
+		}
+
+		// The vertices of the triangle enter the cache first, pushing the others back (LRU)
+		for (unsigned int v : cache)
+		{
+			if (v != newCache[0] && v != newCache[1] && v != newCache[2]) newCache.push_back(v);
+		}
+		cache.swap(newCache);
+
+		for (size_t i = 0; i < cache.size(); i++)
+		{
+			const unsigned int v = cache[i];
+			cachePosition[v] = i < (size_t)kForsythCacheSize ? (int)i : -1;
+			vertexScore[v] = forsythVertexScore(cachePosition[v], remainingValence[v]);
+		}
+
+		// Only the triangles around the cache changed score, the best next one is among them
+		bestTriangle = -1;
+		float bestScore = -1.0f;
+		for (unsigned int v : cache)
+		{
+			const unsigned int* triangles = &vertexTriangles[firstTriangle[v]];
+			for (unsigned int i = 0; i < remainingValence[v]; i++)
+			{
+				const unsigned int neighbour = triangles[i];
+				const float score = vertexScore[indices[neighbour * 3]] + vertexScore[indices[neighbour * 3 + 1]] + vertexScore[indices[neighbour * 3 + 2]];
+				if (score > bestScore)
+				{
+					bestScore = score;
+					bestTriangle = neighbour;
+				}
+			}
+		}
+
+		if (cache.size() > (size_t)kForsythCacheSize) cache.resize(kForsythCacheSize);
+	}
+
+	indices.swap(optimized);
+}
+
+namespace
+{
+	inline uint64_t edgeKey(unsigned int from, unsigned int to)
+	{
+		return ((uint64_t)from << 32) | to;
+	}
+}
+
+std::vector<unsigned int> MeshOptimizer::buildStrips(const std::vector<unsigned int>& indices, unsigned int restartIndex)
+{
+	const size_t triangleCount = indices.size() / 3;
+
+	// Each triangle, by the directed edges of its winding. Two consistently wound neighbours
+	// share an edge in opposite directions.
+	std::unordered_map<uint64_t, unsigned int> triangleByEdge;
+	triangleByEdge.reserve(indices.size());
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		for (int corner = 0; corner < 3; corner++)
+		{
+			triangleByEdge.emplace(edgeKey(indices[t * 3 + corner], indices[t * 3 + (corner + 1) % 3]), (unsigned int)t);
+		}
+	}
+
+	std::vector<bool> used(triangleCount, false);
+
+	// The unused triangle having the directed edge from -> to, and its third vertex
+	auto findTriangle = [&](unsigned int from, unsigned int to, unsigned int& third) -> long long {
+		const auto found = triangleByEdge.find(edgeKey(from, to));
+		if (found == triangleByEdge.end() || used[found->second]) return -1;
+
+		const unsigned int t = found->second;
+		for (int corner = 0; corner < 3; corner++)
+		{
+			const unsigned int v = indices[t * 3 + corner];
+			if (v != from && v != to) third = v;
+		}
+		return t;
+	};
+
+	std::vector<unsigned int> strips;
+	strips.reserve(indices.size());
+	for (size_t start = 0; start < triangleCount; start++)
+	{
+		if (used[start]) continue;
+		used[start] = true;
+
+		// Start with the rotation of the triangle that can be continued, if any
+		const unsigned int* corners = &indices[start * 3];
+		int rotation = 0;
+		for (int r = 0; r < 3; r++)
+		{
+			unsigned int third;
+			// The second triangle of a strip is (s2, s1, x), it has the directed edge s2 -> s1
+			if (findTriangle(corners[(r + 2) % 3], corners[(r + 1) % 3], third) >= 0)
+			{
+				rotation = r;
+				break;
+			}
+		}
+
+		if (!strips.empty()) strips.push_back(restartIndex);
+		const size_t stripStart = strips.size();
+		for (int corner = 0; corner < 3; corner++) strips.push_back(corners[(rotation + corner) % 3]);
+
+		while (true)
+		{
+			// The window (s[k-1], s[k], x) is wound as is when it starts at an even position, reversed otherwise
+			const size_t k = strips.size() - 1;
+			const bool evenWindow = ((k - 1 - stripStart) % 2) == 0;
+			const unsigned int a = strips[k - 1], b = strips[k];
+
+			unsigned int third;
+			const long long next = evenWindow ? findTriangle(a, b, third) : findTriangle(b, a, third);
+			if (next < 0) break;
+
+			used[(size_t)next] = true;
+			strips.push_back(third);
+		}
+	}
+	return strips;
+}
+
+std::vector<unsigned int> MeshOptimizer::unpackStrips(const std::vector<unsigned int>& strips, unsigned int restartIndex)
+{
+	std::vector<unsigned int> triangles;
+	size_t stripStart = 0;
+	for (size_t i = 0; i <= strips.size(); i++)
+	{
+		if (i < strips.size() && strips[i] != restartIndex) continue;
+
+		for (size_t j = stripStart; j + 2 < i; j++)
+		{
+			const unsigned int a = strips[j], b = strips[j + 1], c = strips[j + 2];
+			if (a == b || b == c || a == c) continue; // Degenerate, not rasterized
+
+			const bool even = ((j - stripStart) % 2) == 0;
+			triangles.push_back(even ? a : b);
+			triangles.push_back(even ? b : a);
+			triangles.push_back(c);
+		}
+		stripStart = i + 1;
+	}
+	return triangles;
+}
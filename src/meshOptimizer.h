@@ -0,0 +1,51 @@
+#ifndef INCLUDE_MESHOPTIMIZER
+#define INCLUDE_MESHOPTIMIZER
+
+#include <cstddef>
+#include <vector>
+
+/*
+* @brief Index buffer optimizations for the post-transform vertex cache of the GPU.
+*/
+class MeshOptimizer
+{
+public:
+	/*
+	* @brief Average cache miss ratio: vertices transformed per triangle, with a FIFO cache.
+	* 
+	* 0.5 is the ideal for large regular grids, 3 means no vertex is ever reused.
+	* 
+	* @param indices The triangle list.
+	* @param vertexCount The amount of vertices indexed.
+	* @param cacheSize The amount of vertices the simulated cache holds.
+	*/
+	static float computeAcmr(const std::vector<unsigned int>& indices, size_t vertexCount, int cacheSize = 16);
+
+	/*
+	* @brief Reorders the triangles so that consecutive triangles share vertices (Forsyth's algorithm).
+	* 
+	* @param indices The triangle list, reordered in place. The winding of each triangle is kept.
+	* @param vertexCount The amount of vertices indexed.
+	*/
+	static void optimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount);
+
+	/*
+	* @brief Converts a triangle list into triangle strips separated by a primitive restart index.
+	* 
+	* The strips follow the order of the list as much as possible, so optimize it first.
+	* The winding of each triangle is kept.
+	* 
+	* @param indices The triangle list.
+	* @param restartIndex The index separating two strips, must not be a vertex.
+	* 
+	* @return The strips.
+	*/
+	static std::vector<unsigned int> buildStrips(const std::vector<unsigned int>& indices, unsigned int restartIndex);
+
+	/*
+	* @brief Converts triangle strips back into a triangle list, e.g. to compute their ACMR.
+	*/
+	static std::vector<unsigned int> unpackStrips(const std::vector<unsigned int>& strips, unsigned int restartIndex);
+};
+
+#endif
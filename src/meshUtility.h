@@ -24,6 +24,55 @@ public:
 	{
 		return glm::translate(glm::mat4(1.0f), position);
 	}
+
+	// Packs a unit vector in the GL_INT_2_10_10_10_REV layout, x in the lowest bits
+	// Like glm::packSnorm3x10_1x2(), but usable in constant expressions, for the baked meshes
+	constexpr static glm::uint32 packNormal(float x, float y, float z)
+	{
+		return (glm::uint32)(roundToInt(clampFloat(x, -1.0f, 1.0f) * 511.0f) & 0x3FF)
+			| (glm::uint32)(roundToInt(clampFloat(y, -1.0f, 1.0f) * 511.0f) & 0x3FF) << 10
+			| (glm::uint32)(roundToInt(clampFloat(z, -1.0f, 1.0f) * 511.0f) & 0x3FF) << 20;
+	}
+
+	inline static glm::uint32 packNormal(const glm::vec3& normal)
+	{
+		return packNormal(normal.x, normal.y, normal.z);
+	}
+
+	// Packs texture coordinates as two normalized GL_UNSIGNED_SHORT, u first
+	// u is in [0, 2] so the triangles crossing the seam of the textures can go past 1, vertexShader.glsl doubles it back
+	constexpr static glm::uint32 packTexCoord(float u, float v)
+	{
+		return (glm::uint32)roundToInt(clampFloat(u / 2.0f, 0.0f, 1.0f) * 65535.0f)
+			| (glm::uint32)roundToInt(clampFloat(v, 0.0f, 1.0f) * 65535.0f) << 16;
+	}
+
+	inline static glm::uint32 packTexCoord(const glm::vec2& texCoord)
+	{
+		return packTexCoord(texCoord.x, texCoord.y);
+	}
+
+private:
+	// Rounds half away from zero, like glm::round()
+	constexpr static int roundToInt(float value)
+	{
+		return value < 0.0f ? -(int)(0.5f - value) : (int)(value + 0.5f);
+	}
+
+	constexpr static float clampFloat(float value, float low, float high)
+	{
+		return value < low ? low : (value > high ? high : value);
+	}
+};
+
+/*
+* @brief Interleaved vertex layout of the sphere meshes, 20 bytes per vertex.
+*/
+struct PackedVertex
+{
+	glm::vec3 position;  // Local space position, location 0
+	glm::uint32 normal;   // GL_INT_2_10_10_10_REV normalized, location 1
+	glm::uint32 texCoord; // Two GL_UNSIGNED_SHORT normalized, location 4
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,76 @@
+#include "orbitTrails.h"
+#include "frameStats.h"
+
+#include <algorithm>
+
+OrbitTrails::~OrbitTrails()
+{
+	if (m_buffer == 0) return; // Never initialized
+
+	glDeleteTextures(1, &m_texture);
+	glDeleteBuffers(1, &m_buffer);
+	glDeleteVertexArrays(1, &m_vao);
+}
+
+void OrbitTrails::init(GLuint program, GLuint textureUnit, size_t trailCount, size_t pointsPerTrail)
+{
+	// GL 3.3 only guarantees 65536 texels per texture buffer, most drivers allow far more
+	GLint maxTexels = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+	m_trailCount = std::max<size_t>(trailCount, 1);
+	m_rowCount = std::max<size_t>(std::min(pointsPerTrail, (size_t)maxTexels / m_trailCount), 2);
+	m_head = 0;
+	m_pointCount = 0;
+	m_row.assign(m_trailCount, glm::vec4(0.0f));
+	m_textureUnit = textureUnit;
+
+	const GLsizeiptr bufferSize = (GLsizeiptr)(sizeof(glm::vec4) * m_trailCount * m_rowCount);
+	glGenBuffers(1, &m_buffer);
+	glBindBuffer(GL_TEXTURE_BUFFER, m_buffer);
+	glBufferData(GL_TEXTURE_BUFFER, bufferSize, nullptr, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	glGenVertexArrays(1, &m_vao);
+	glGenTextures(1, &m_texture);
+	glBindTexture(GL_TEXTURE_BUFFER, m_texture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_buffer); // RGB32F texture buffers need GL 4.0
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+	glUseProgram(program);
+	glUniform1i(glGetUniformLocation(program, "points"), (GLint)textureUnit);
+	m_headLocation = glGetUniformLocation(program, "head");
+	m_rowCountLocation = glGetUniformLocation(program, "rowCount");
+	m_trailCountLocation = glGetUniformLocation(program, "trailCount");
+}
+
+void OrbitTrails::append(const glm::vec3* positions)
+{
+	for (size_t trail = 0; trail < m_trailCount; trail++) m_row[trail] = glm::vec4(positions[trail], 1.0f);
+
+	m_head = (m_head + 1) % m_rowCount;
+	m_pointCount = std::min(m_pointCount + 1, m_rowCount);
+
+	const size_t rowBytes = sizeof(glm::vec4) * m_trailCount;
+	glBindBuffer(GL_TEXTURE_BUFFER, m_buffer);
+	glBufferSubData(GL_TEXTURE_BUFFER, (GLintptr)(m_head * rowBytes), (GLsizeiptr)rowBytes, m_row.data());
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+	FrameStats::current().bytesUploaded += rowBytes;
+}
+
+void OrbitTrails::render(size_t trailCount)
+{
+	trailCount = std::min(trailCount, m_trailCount);
+	if (m_pointCount < 2 || trailCount == 0) return;
+
+	glUniform1i(m_headLocation, (GLint)m_head);
+	glUniform1i(m_rowCountLocation, (GLint)m_rowCount);
+	glUniform1i(m_trailCountLocation, (GLint)m_trailCount);
+
+	glActiveTexture(GL_TEXTURE0 + m_textureUnit);
+	glBindTexture(GL_TEXTURE_BUFFER, m_texture);
+	glActiveTexture(GL_TEXTURE0);
+
+	glBindVertexArray(m_vao);
+	glDrawArraysInstanced(GL_LINE_STRIP, 0, (GLsizei)m_pointCount, (GLsizei)trailCount);
+	glBindVertexArray(0); // Unbinding
+}
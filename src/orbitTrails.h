@@ -0,0 +1,78 @@
+#ifndef INCLUDE_ORBITTRAILS
+#define INCLUDE_ORBITTRAILS
+
+#include <dep/glm/glm.hpp>
+
+#include <glad/gl.h>
+
+#include <cstddef>
+#include <vector>
+
+/*
+* @brief The trails left behind the bodies, all in one GPU ring buffer and drawn with a single call.
+*
+* The ring has a row of points per time step, one point per trail: appending a step uploads a single
+* contiguous row, over the oldest one. trailVertexShader.glsl draws each trail as an instance of a
+* line strip, walking back the rows from the newest one with gl_VertexID, and fades them by age.
+*/
+class OrbitTrails
+{
+public:
+	OrbitTrails() = default;
+
+	OrbitTrails(const OrbitTrails&) = delete;
+	OrbitTrails& operator=(const OrbitTrails&) = delete;
+
+	/*
+	* @brief Frees the ring buffer.
+	*/
+	~OrbitTrails();
+
+	/*
+	* @brief Creates the ring buffer, and binds it to a texture unit in the program.
+	*
+	* @param program The GPU program made of trailVertexShader.glsl and trailFragmentShader.glsl.
+	* @param textureUnit The texture unit the ring buffer is bound to.
+	* @param trailCount The amount of trails.
+	* @param pointsPerTrail The amount of steps kept, lowered if the ring would not fit in a texture buffer.
+	*/
+	void init(GLuint program, GLuint textureUnit, size_t trailCount, size_t pointsPerTrail);
+
+	/*
+	* @brief Appends a point to every trail, replacing the oldest ones once the ring is full.
+	*
+	* @param positions The new point of each trail, in world space.
+	*/
+	void append(const glm::vec3* positions);
+
+	/*
+	* @brief Draws the first trails. The program must be in use.
+	*
+	* @param trailCount The amount of trails to draw, from the first one.
+	*/
+	void render(size_t trailCount);
+
+	/*
+	* @brief Forgets every point, e.g. when the bodies jump.
+	*/
+	inline void clear() { m_pointCount = 0; }
+
+	inline size_t getTrailCount() const { return m_trailCount; }
+
+private:
+	GLuint m_buffer = 0, m_texture = 0;
+	GLuint m_vao = 0; // No attribute is read, but drawing requires a VAO
+	GLuint m_textureUnit = 0;
+
+	size_t m_trailCount = 0;
+	size_t m_rowCount = 0;   // Points per trail
+	size_t m_head = 0;       // Row of the newest points
+	size_t m_pointCount = 0; // Points per trail written so far, at most m_rowCount
+
+	// Staging of the row being appended
+	std::vector<glm::vec4> m_row;
+
+	GLint m_headLocation = -1, m_rowCountLocation = -1, m_trailCountLocation = -1;
+};
+
+#endif
@@ -0,0 +1,12 @@
+#version 330 core	     // Minimal GL version support expected from the GPU
+
+in vec4 fColor;
+
+out vec4 color; // Shader output: the color response attached to this fragment
+
+void main() {
+	// The square point is cut to a disc, the pixel at its center is always kept
+	vec2 offset = 2.0 * gl_PointCoord - 1.0;
+	if (dot(offset, offset) > 1.0) discard;
+	color = fColor;
+}
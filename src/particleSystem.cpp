@@ -0,0 +1,131 @@
+#include "particleSystem.h"
+#include "frameStats.h"
+
+#include <cmath>
+#include <cstring>
+
+ParticleSystem::ParticleSystem(ThreadPool* threadPool) :
+	m_threadPool(threadPool)
+{
+}
+
+ParticleSystem::~ParticleSystem()
+{
+	if (m_vao == 0) return; // Never initialized
+
+	glDeleteBuffers(1, &m_attributeBuffer);
+	glDeleteVertexArrays(1, &m_vao);
+}
+
+void ParticleSystem::init()
+{
+	glGenVertexArrays(1, &m_vao);
+	glGenBuffers(1, &m_attributeBuffer);
+
+	// The positions are streamed, their pointers are set by render()
+	glBindVertexArray(m_vao);
+	for (GLuint location = 0; location <= 4; location++) glEnableVertexAttribArray(location);
+	glBindVertexArray(0); // Unbinding
+
+	m_attributesDirty = true;
+}
+
+size_t ParticleSystem::addOrbitingParticle(const OrbitalElements& orbit, float radius, const glm::vec4& color)
+{
+	const size_t particle = m_orbits.size();
+	m_orbits.resize(particle + 1);
+	m_orbits.set(particle, orbit);
+	m_attributes.push_back(makeAttributes(radius, color));
+	m_attributesDirty = true;
+	return particle;
+}
+
+void ParticleSystem::setFreeParticles(const glm::dvec3* positions, size_t count, float radius, const glm::vec4& color)
+{
+	// The static buffer only changes when the free particles are added or removed, not when they move
+	const ParticleAttributes attributes = makeAttributes(radius, color);
+	if (count != m_freePositions.size() || std::memcmp(&attributes, &m_freeAttributes, sizeof(ParticleAttributes)) != 0)
+	{
+		m_freeAttributes = attributes;
+		m_attributesDirty = true;
+	}
+
+	m_freePositions.resize(count);
+	for (size_t particle = 0; particle < count; particle++) m_freePositions[particle] = glm::vec3(positions[particle]);
+}
+
+void ParticleSystem::computePositions(double time, const glm::vec3& focus, float* x, float* y, float* z)
+{
+	if (m_orbits.size() == 0) return;
+
+	if (std::abs(time - m_orbits.getEpoch()) > kRebaseInterval) m_orbits.rebase(time);
+
+	forEachChunk(m_orbits.size(), [&](size_t first, size_t last) {
+		KeplerKernel::computePositions(m_orbits, time, focus, x, y, z, first, last);
+	});
+}
+
+void ParticleSystem::update(double time, const glm::vec3& focus)
+{
+	m_streamedCount = getParticleCount();
+	if (m_streamedCount == 0) return;
+
+	// Each coordinate array holds the free particles, then the orbiting ones with the padding the kernel writes to
+	const size_t freeCount = m_freePositions.size();
+	m_streamedStride = freeCount + getPaddedOrbitingCount();
+	float* x = (float*)m_positionStream.map(3 * sizeof(float) * m_streamedStride);
+	float* y = x + m_streamedStride;
+	float* z = y + m_streamedStride;
+
+	for (size_t particle = 0; particle < freeCount; particle++)
+	{
+		x[particle] = m_freePositions[particle].x;
+		y[particle] = m_freePositions[particle].y;
+		z[particle] = m_freePositions[particle].z;
+	}
+	computePositions(time, focus, x + freeCount, y + freeCount, z + freeCount);
+
+	m_streamedOffset = m_positionStream.unmap();
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void ParticleSystem::render()
+{
+	if (m_streamedCount == 0) return;
+
+	glBindVertexArray(m_vao);
+
+	if (m_attributesDirty)
+	{
+		std::vector<ParticleAttributes> attributes(m_freePositions.size(), m_freeAttributes);
+		attributes.insert(attributes.end(), m_attributes.begin(), m_attributes.end());
+
+		const size_t bytes = sizeof(ParticleAttributes) * attributes.size();
+		glBindBuffer(GL_ARRAY_BUFFER, m_attributeBuffer);
+		glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)bytes, attributes.data(), GL_STATIC_DRAW);
+		glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(ParticleAttributes), (void*)offsetof(ParticleAttributes, radius));
+		glVertexAttribPointer(4, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ParticleAttributes), (void*)offsetof(ParticleAttributes, color));
+		FrameStats::current().bytesUploaded += bytes;
+		m_attributesDirty = false;
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_positionStream.getBuffer());
+	for (GLuint coordinate = 0; coordinate < 3; coordinate++)
+	{
+		glVertexAttribPointer(coordinate, 1, GL_FLOAT, GL_FALSE, sizeof(float),
+			(void*)(m_streamedOffset + coordinate * sizeof(float) * m_streamedStride));
+	}
+
+	// The padding after the orbiting particles is not drawn
+	glDrawArrays(GL_POINTS, 0, (GLsizei)m_streamedCount);
+	glBindVertexArray(0); // Unbinding
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	m_positionStream.fence(); // The region can be rewritten once the draw reading it is done
+}
+
+ParticleSystem::ParticleAttributes ParticleSystem::makeAttributes(float radius, const glm::vec4& color)
+{
+	const glm::vec4 clamped = glm::clamp(color, 0.0f, 1.0f) * 255.0f + 0.5f;
+	return ParticleAttributes{ radius, { (GLubyte)clamped.r, (GLubyte)clamped.g, (GLubyte)clamped.b, (GLubyte)clamped.a } };
+}
@@ -0,0 +1,163 @@
+#ifndef INCLUDE_PARTICLESYSTEM
+#define INCLUDE_PARTICLESYSTEM
+
+#include "ephemeris.h"
+#include "keplerKernel.h"
+#include "streamBuffer.h"
+#include "threadPool.h"
+
+#include <dep/glm/glm.hpp>
+
+#include <glad/gl.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+/*
+* @brief Up to millions of small bodies, e.g. the asteroid belts, drawn as points with a single call.
+*
+* The orbiting particles are structure-of-arrays orbits, placed by the KeplerKernel on the workers: they
+* are computed from scratch at any time, so each frame places them where they are drawn, with nothing
+* to interpolate. Free particles, moved by someone else like the gravity simulation, come before them.
+*
+* Only the positions are streamed, one float array per coordinate in a single region of a StreamBuffer,
+* which the workers write straight into: each position is written once per frame. The size and the
+* color of each particle do not change, they are kept in a static buffer.
+* particleVertexShader.glsl sizes the points with the distance, and particleFragmentShader.glsl rounds them.
+*/
+class ParticleSystem
+{
+public:
+	/*
+	* @param threadPool The workers placing the particles, nullptr to do it on the calling thread.
+	*/
+	explicit ParticleSystem(ThreadPool* threadPool = nullptr);
+
+	ParticleSystem(const ParticleSystem&) = delete;
+	ParticleSystem& operator=(const ParticleSystem&) = delete;
+
+	/*
+	* @brief Frees the static buffer and the VAO.
+	*/
+	~ParticleSystem();
+
+	/*
+	* @brief Creates the GL objects. The particles are drawn by a program made of particleVertexShader.glsl and particleFragmentShader.glsl.
+	*/
+	void init();
+
+	/*
+	* @brief Adds a particle on a Keplerian orbit around the focus given to update().
+	*
+	* @param orbit Its orbit.
+	* @param radius Its radius, in world units.
+	* @param color Its color, the alpha being its opacity.
+	*
+	* @return The index of the particle.
+	*/
+	size_t addOrbitingParticle(const OrbitalElements& orbit, float radius, const glm::vec4& color);
+
+	/*
+	* @brief Sets the particles drawn with the orbiting ones, replacing the previous ones.
+	* To call whenever they move: only their positions are copied.
+	*
+	* @param positions Their positions, in world units.
+	* @param count The amount of particles, 0 to remove them.
+	* @param radius The radius of each of them, in world units.
+	* @param color The color of each of them, the alpha being their opacity.
+	*/
+	void setFreeParticles(const glm::dvec3* positions, size_t count, float radius, const glm::vec4& color);
+
+	/*
+	* @brief Streams the positions of every particle, the orbiting ones placed at a time on the workers.
+	*
+	* @param time The time, in seconds since the epoch.
+	* @param focus The world coordinates of the focus of the orbits, e.g. the sun.
+	*/
+	void update(double time, const glm::vec3& focus);
+
+	/*
+	* @brief Draws the particles streamed by the last update(). The program must be in use.
+	*/
+	void render();
+
+	/*
+	* @brief Places the orbiting particles at a time, on the workers, without any GL call.
+	*
+	* @param time The time, in seconds since the epoch.
+	* @param focus The world coordinates of the focus of the orbits, e.g. the sun.
+	* @param x Receives the x coordinate of orbiting particle i at x[i], must hold getPaddedOrbitingCount() floats.
+	* @param y Idem for y.
+	* @param z Idem for z.
+	*/
+	void computePositions(double time, const glm::vec3& focus, float* x, float* y, float* z);
+
+	inline size_t getOrbitingCount() const { return m_orbits.size(); }
+	inline size_t getFreeCount() const { return m_freePositions.size(); }
+	inline size_t getParticleCount() const { return getOrbitingCount() + getFreeCount(); }
+
+	/*
+	* @brief Get the amount of orbiting particles rounded up to a multiple of 8, the room the kernel writes to.
+	*/
+	inline size_t getPaddedOrbitingCount() const { return (getOrbitingCount() + 7) & ~(size_t)7; }
+
+private:
+	// The static part of a particle, read with the streamed position
+	struct ParticleAttributes
+	{
+		float radius;
+		GLubyte color[4];
+	};
+
+	// The orbits moved to a new epoch past this time, so that the float time given to the kernel stays exact enough
+	static constexpr double kRebaseInterval = 1024.0;
+
+	// Orbits placed per task, a multiple of 8 as the kernel needs
+	static const size_t kChunkSize = 16384;
+
+	ThreadPool* m_threadPool;
+
+	KeplerOrbitsSoA m_orbits;
+	std::vector<glm::vec3> m_freePositions;
+	std::vector<ParticleAttributes> m_attributes; // Of the orbiting particles
+	ParticleAttributes m_freeAttributes = {};      // Shared by the free particles
+
+	GLuint m_vao = 0;
+	GLuint m_attributeBuffer = 0;
+	bool m_attributesDirty = true;
+
+	// Rewritten every frame, hence streamed: the free particles, the orbiting ones and their padding, for each coordinate
+	StreamBuffer m_positionStream{ GL_ARRAY_BUFFER };
+	size_t m_streamedCount = 0; // Particles written by the last update()
+	GLintptr m_streamedOffset = 0;
+	size_t m_streamedStride = 0; // Floats from one coordinate array to the next
+
+	/*
+	* @brief Runs a function on the chunks of a range of particles, on the workers if there are any.
+	*
+	* @param count The amount of particles, from 0.
+	* @param function The function to run, taking the first and one past the last particle of a chunk.
+	*/
+	template <typename F>
+	void forEachChunk(size_t count, F function)
+	{
+		const size_t chunkCount = (count + kChunkSize - 1) / kChunkSize;
+		auto runChunk = [&](size_t chunk) {
+			function(chunk * kChunkSize, std::min(count, (chunk + 1) * kChunkSize));
+		};
+
+		if (m_threadPool != nullptr)
+		{
+			m_threadPool->parallelFor(chunkCount, runChunk);
+		}
+		else
+		{
+			for (size_t chunk = 0; chunk < chunkCount; chunk++) runChunk(chunk);
+		}
+	}
+
+	static ParticleAttributes makeAttributes(float radius, const glm::vec4& color);
+};
+
+#endif
@@ -0,0 +1,27 @@
+#version 330 core            // Minimal GL version support expected from the GPU
+
+// One point per particle, each coordinate streamed in its own array
+layout(location=0) in float vX;
+layout(location=1) in float vY;
+layout(location=2) in float vZ;
+
+// Static, set once per particle
+layout(location=3) in float vRadius;
+layout(location=4) in vec4 vColor; // Packed as normalized unsigned bytes
+
+uniform mat4 viewMat, projMat;
+uniform float viewportHeight;
+uniform float maxPointSize;
+
+out vec4 fColor; // Sent to particleFragmentShader
+
+void main() {
+	vec4 viewPosition = viewMat * vec4(vX, vY, vZ, 1.0);
+	gl_Position = projMat * viewPosition;
+
+	// The diameter on screen shrinks with the distance
+	// Under a pixel the point keeps a pixel and fades instead, so that the far particles do not flicker
+	float diameter = vRadius * projMat[1][1] * viewportHeight / max(-viewPosition.z, 1e-4);
+	gl_PointSize = clamp(diameter, 1.0, maxPointSize);
+	fColor = vec4(vColor.rgb, vColor.a * min(diameter, 1.0));
+}
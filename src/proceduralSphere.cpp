@@ -0,0 +1,88 @@
+#include "proceduralSphere.h"
+
+static_assert(sizeof(ProceduralInstance) % sizeof(glm::vec4) == 0, "A body must be made of whole texels");
+
+ProceduralSphere::~ProceduralSphere()
+{
+	if (m_vao == 0) return; // Never initialized
+
+	glDeleteTextures(1, &m_texture);
+	glDeleteVertexArrays(1, &m_vao);
+}
+
+void ProceduralSphere::init(GLuint program, GLuint impostorProgram, GLuint textureUnit)
+{
+	glGenVertexArrays(1, &m_vao);
+	glGenTextures(1, &m_texture);
+	m_textureUnit = textureUnit;
+
+	glUseProgram(program);
+	glUniform1i(glGetUniformLocation(program, "bodies"), (GLint)textureUnit);
+	m_firstTexelLocation = glGetUniformLocation(program, "firstTexel");
+	m_resolutionLocation = glGetUniformLocation(program, "resolution");
+
+	glUseProgram(impostorProgram);
+	glUniform1i(glGetUniformLocation(impostorProgram, "bodies"), (GLint)textureUnit);
+	m_impostorFirstTexelLocation = glGetUniformLocation(impostorProgram, "firstTexel");
+}
+
+ProceduralInstance* ProceduralSphere::mapInstances(size_t count)
+{
+	m_instanceCount = count;
+	if (count == 0) return nullptr;
+
+	return (ProceduralInstance*)m_instanceStream.map(sizeof(ProceduralInstance) * count);
+}
+
+void ProceduralSphere::unmapInstances()
+{
+	if (m_instanceCount == 0) return;
+
+	// The regions are aligned on 256 bytes, hence on texels
+	m_firstTexel = (size_t)m_instanceStream.unmap() / kTexelSize;
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	if (m_attachedBuffer != m_instanceStream.getBuffer())
+	{
+		m_attachedBuffer = m_instanceStream.getBuffer();
+		glBindTexture(GL_TEXTURE_BUFFER, m_texture);
+		glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_attachedBuffer);
+		glBindTexture(GL_TEXTURE_BUFFER, 0);
+	}
+}
+
+void ProceduralSphere::bindBodies()
+{
+	glActiveTexture(GL_TEXTURE0 + m_textureUnit);
+	glBindTexture(GL_TEXTURE_BUFFER, m_texture);
+	glActiveTexture(GL_TEXTURE0);
+
+	glBindVertexArray(m_vao);
+}
+
+void ProceduralSphere::renderInstances(size_t first, size_t count, size_t resolution)
+{
+	if (count == 0) return;
+
+	glUniform1i(m_firstTexelLocation, (GLint)(m_firstTexel + first * kTexelsPerInstance));
+	glUniform1i(m_resolutionLocation, (GLint)resolution);
+
+	bindBodies();
+	glDrawArraysInstanced(GL_TRIANGLES, 0, (GLsizei)vertexCount(resolution), (GLsizei)count);
+	glBindVertexArray(0); // Unbinding
+
+	m_instanceStream.fence(); // The region can be rewritten once the draws reading it are done
+}
+
+void ProceduralSphere::renderImpostors(size_t first, size_t count)
+{
+	if (count == 0) return;
+
+	glUniform1i(m_impostorFirstTexelLocation, (GLint)(m_firstTexel + first * kTexelsPerInstance));
+
+	bindBodies();
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)count);
+	glBindVertexArray(0); // Unbinding
+
+	m_instanceStream.fence(); // The region can be rewritten once the draws reading it are done
+}
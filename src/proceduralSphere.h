@@ -0,0 +1,138 @@
+#ifndef INCLUDE_PROCEDURALSPHERE
+#define INCLUDE_PROCEDURALSPHERE
+
+#include "mesh.h"
+#include "streamBuffer.h"
+
+#include <dep/glm/glm.hpp>
+
+#include <glad/gl.h>
+
+#include <cstddef>
+
+/*
+* @brief Per-body data read by proceduralVertexShader.glsl from its texture buffer, five RGBA32F texels.
+*/
+struct ProceduralInstance
+{
+	glm::mat4 modelMatrix; // Local to world transformation of the body
+	glm::vec4 material;    // Texture layer, emissive flag, unused, unused
+};
+
+/*
+* @brief Draws spheres without any vertex buffer, the bodies being fetched from a texture buffer with gl_InstanceID.
+*
+* As triangles, proceduralVertexShader.glsl computes the vertices of a UV sphere from gl_VertexID.
+* No geometry is stored nor read, and every resolution is available at no cost. In exchange, the
+* vertices are not shared between triangles, so each one is computed about six times.
+*
+* As impostors, impostorVertexShader.glsl draws a billboard of four vertices around the sphere, and
+* impostorFragmentShader.glsl ray-casts it: the silhouette is exact whatever the size on screen. Each
+* fragment writes its depth, which disables the early depth test, so this is for the small bodies.
+*/
+class ProceduralSphere
+{
+public:
+	ProceduralSphere() = default;
+
+	ProceduralSphere(const ProceduralSphere&) = delete;
+	ProceduralSphere& operator=(const ProceduralSphere&) = delete;
+
+	/*
+	* @brief Frees the empty VAO and the texture of the bodies.
+	*/
+	~ProceduralSphere();
+
+	/*
+	* @brief Creates the GL objects, and binds the bodies buffer of the programs to a texture unit.
+	*
+	* @param program The GPU program made of proceduralVertexShader.glsl and fragmentShader.glsl.
+	* @param impostorProgram The GPU program made of impostorVertexShader.glsl and impostorFragmentShader.glsl.
+	* @param textureUnit The texture unit the bodies buffer is bound to, not the one of the body textures.
+	*/
+	void init(GLuint program, GLuint impostorProgram, GLuint textureUnit);
+
+	/*
+	* @brief Gives direct access to the GPU memory of the bodies drawn by renderInstances() and renderImpostors(), replacing the previous ones.
+	*
+	* @param count The amount of bodies to draw this frame, over every resolution and the impostors.
+	*
+	* @return Where to write the count bodies, valid until unmapInstances().
+	*/
+	ProceduralInstance* mapInstances(size_t count);
+
+	/*
+	* @brief Hands the bodies written since mapInstances() to the GPU.
+	*/
+	void unmapInstances();
+
+	/*
+	* @brief Draws some of the bodies written since the last mapInstances() with a single instanced draw call.
+	* The program must be in use.
+	*
+	* @param first The first body to draw.
+	* @param count The amount of bodies to draw.
+	* @param resolution The resolution of their sphere, as for Mesh::genSphere().
+	*/
+	void renderInstances(size_t first, size_t count, size_t resolution);
+
+	/*
+	* @brief Draws some of the bodies written since the last mapInstances() as impostors, with a single instanced draw call.
+	* The impostor program must be in use.
+	*
+	* @param first The first body to draw.
+	* @param count The amount of bodies to draw.
+	*/
+	void renderImpostors(size_t first, size_t count);
+
+	/*
+	* @brief Whether a body is small enough on screen to be drawn as an impostor.
+	*
+	* @param projectedRadius The radius of the body on screen, in pixels.
+	*/
+	inline static bool isImpostor(float projectedRadius) { return projectedRadius <= kMaxImpostorRadius; }
+
+	/*
+	* @brief Get the amount of vertices drawn per sphere, six per quad.
+	*/
+	inline static size_t vertexCount(size_t resolution) { return 6 * resolution * (resolution - 1); }
+
+	/*
+	* @brief Get the procedural counterpart of the instance of a Mesh.
+	*/
+	inline static ProceduralInstance makeInstance(const MeshInstance& instance)
+	{
+		return ProceduralInstance{ instance.modelMatrix, glm::vec4(instance.textureLayer, instance.emissive, 0.0f, 0.0f) };
+	}
+
+private:
+	// Past this radius, in pixels, the fragments of an impostor cost more than the vertices of a mesh
+	static constexpr float kMaxImpostorRadius = 48.0f;
+
+	// A texel of the bodies buffer
+	static constexpr size_t kTexelSize = sizeof(glm::vec4);
+	static constexpr size_t kTexelsPerInstance = sizeof(ProceduralInstance) / kTexelSize;
+
+	// Drawing requires a VAO to be bound, even if it has no attribute
+	GLuint m_vao = 0;
+
+	// The texture buffer reading m_instanceStream, reattached whenever the stream reallocates its buffer
+	GLuint m_texture = 0;
+	GLuint m_textureUnit = 0;
+	GLuint m_attachedBuffer = 0;
+
+	// Rewritten every frame, hence streamed
+	StreamBuffer m_instanceStream{ GL_TEXTURE_BUFFER };
+	size_t m_instanceCount = 0;
+	size_t m_firstTexel = 0;
+
+	GLint m_firstTexelLocation = -1, m_resolutionLocation = -1;
+	GLint m_impostorFirstTexelLocation = -1;
+
+	/*
+	* @brief Binds the bodies buffer to its texture unit, and the empty VAO.
+	*/
+	void bindBodies();
+};
+
+#endif
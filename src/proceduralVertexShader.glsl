@@ -0,0 +1,57 @@
+#version 330 core            // Minimal GL version support expected from the GPU
+
+// No vertex attribute: the vertices of the UV sphere are computed from gl_VertexID,
+// and the body is fetched from the bodies buffer with gl_InstanceID
+
+// Five texels per body: the four columns of the model matrix, then the texture layer and emissive flag
+uniform samplerBuffer bodies;
+uniform int firstTexel; // Of the first body of the draw call
+
+// Amount of meridians and parallels, the poles included, as for a Mesh of the same resolution
+uniform int resolution;
+
+// Sent to fragmentShader
+out vec3 fPosition;
+out vec3 fNormal;
+out vec2 fTexCoord;
+flat out float fTextureLayer;
+flat out float fEmissive;
+
+uniform mat4 viewMat, projMat;
+
+const float kPi = 3.14159265358979;
+
+// The two triangles of a quad, as (parallel, meridian) steps from its upper left corner,
+// counter-clockwise seen from outside like the ones of UVSphere
+const ivec2 kCorners[6] = ivec2[6](ivec2(0, 0), ivec2(1, 0), ivec2(0, 1), ivec2(0, 1), ivec2(1, 0), ivec2(1, 1));
+
+void main() {
+        // Six vertices per quad, resolution quads per row, resolution - 1 rows from the north pole to the south one
+        // The rows touching a pole have one degenerate triangle per quad, discarded before rasterization
+        int quad = gl_VertexID / 6;
+        int column = quad % resolution;
+        ivec2 corner = ivec2(quad / resolution, column) + kCorners[gl_VertexID % 6];
+
+        float theta = kPi * float(corner.x) / float(resolution - 1);
+        float phi = 2.0 * kPi * float(corner.y % resolution) / float(resolution); // The seam is exactly closed
+        bool pole = corner.x == 0 || corner.x == resolution - 1;
+        float sinTheta = pole ? 0.0 : sin(theta);
+        vec3 localPosition = vec3(sinTheta * cos(phi), sinTheta * sin(phi), pole ? (corner.x == 0 ? 1.0 : -1.0) : cos(theta));
+
+        // At the poles, u is the middle of the quad, so the textures are not sheared around them
+        vec2 texCoord = vec2((pole ? float(column) + 0.5 : float(corner.y)) / float(resolution), float(corner.x) / float(resolution - 1));
+
+        int texel = firstTexel + 5 * gl_InstanceID;
+        mat4 modelMat = mat4(texelFetch(bodies, texel), texelFetch(bodies, texel + 1), texelFetch(bodies, texel + 2), texelFetch(bodies, texel + 3));
+        vec4 material = texelFetch(bodies, texel + 4);
+
+        vec4 worldPosition = modelMat * vec4(localPosition, 1.0);
+        gl_Position = projMat * viewMat * worldPosition;
+
+        fPosition = worldPosition.xyz;
+        fNormal = normalize(mat3(modelMat) * localPosition); // On the unit sphere, the normal is the position itself
+
+        fTexCoord = texCoord;
+        fTextureLayer = material.x;
+        fEmissive = material.y;
+}
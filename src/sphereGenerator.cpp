@@ -0,0 +1,227 @@
+#include "sphereGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+
+const char* SphereGenerator::getName(SphereTopology topology)
+{
+	switch (topology)
+	{
+	case UVSphere: return "uv";
+	case Icosphere: return "icosphere";
+	case CubeSphere: return "cubesphere";
+	}
+	return "unknown";
+}
+
+// Whether the triangle a, b, c is counter-clockwise seen from outside a sphere centered at the origin
+static bool facesOutward(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+{
+	return glm::dot(glm::cross(b - a, c - a), a + b + c) > 0.0f;
+}
+
+void SphereGenerator::genIcosphere(size_t frequency, std::vector<glm::vec3>& positions, std::vector<unsigned int>& indices)
+{
+	const int n = (int)std::max<size_t>(frequency, 1);
+	const float t = (1.0f + std::sqrt(5.0f)) / 2.0f;
+
+	const glm::vec3 corners[12] = {
+		{ -1, t, 0 }, { 1, t, 0 }, { -1, -t, 0 }, { 1, -t, 0 },
+		{ 0, -1, t }, { 0, 1, t }, { 0, -1, -t }, { 0, 1, -t },
+		{ t, 0, -1 }, { t, 0, 1 }, { -t, 0, -1 }, { -t, 0, 1 }
+	};
+	int faces[20][3] = {
+		{ 0, 11, 5 }, { 0, 5, 1 }, { 0, 1, 7 }, { 0, 7, 10 }, { 0, 10, 11 },
+		{ 1, 5, 9 }, { 5, 11, 4 }, { 11, 10, 2 }, { 10, 7, 6 }, { 7, 1, 8 },
+		{ 3, 9, 4 }, { 3, 4, 2 }, { 3, 2, 6 }, { 3, 6, 8 }, { 3, 8, 9 },
+		{ 4, 9, 5 }, { 2, 4, 11 }, { 6, 2, 10 }, { 8, 6, 7 }, { 9, 8, 1 }
+	};
+
+	positions.clear();
+	indices.clear();
+	positions.reserve(10 * n * n + 2);
+	indices.reserve(3 * 20 * n * n);
+
+	// A point is identified by its corners and their integer weights, sorted by corner,
+	// so the points of the edges and corners shared between faces are only created once
+	typedef std::tuple<int, int, int, int, int, int> PointKey;
+	std::map<PointKey, unsigned int> points;
+
+	for (int (&face)[3] : faces)
+	{
+		if (!facesOutward(corners[face[0]], corners[face[1]], corners[face[2]])) std::swap(face[1], face[2]);
+
+		// Point of the face with the weights n-i-j, i, j on its corners
+		auto point = [&](int i, int j) -> unsigned int {
+			std::pair<int, int> weights[3] = { { face[0], n - i - j }, { face[1], i }, { face[2], j } };
+			for (std::pair<int, int>& weight : weights)
+			{
+				if (weight.second == 0) weight.first = -1; // Unused corner
+			}
+			std::sort(weights, weights + 3);
+			const PointKey key(weights[0].first, weights[0].second, weights[1].first, weights[1].second, weights[2].first, weights[2].second);
+
+			auto found = points.find(key);
+			if (found != points.end()) return found->second;
+
+			// Computed from the sorted weights, so the same on every face
+			glm::vec3 position(0.0f);
+			for (const std::pair<int, int>& weight : weights)
+			{
+				if (weight.first >= 0) position += corners[weight.first] * (float)weight.second;
+			}
+			const unsigned int index = (unsigned int)positions.size();
+			positions.push_back(glm::normalize(position));
+			points.emplace(key, index);
+			return index;
+		};
+
+		for (int i = 0; i < n; i++)
+		{
+			for (int j = 0; j < n - i; j++)
+			{
+				const unsigned int p00 = point(i, j), p10 = point(i + 1, j), p01 = point(i, j + 1);
+				indices.insert(indices.end(), { p00, p10, p01 });
+
+				if (i + j < n - 1)
+				{
+					const unsigned int p11 = point(i + 1, j + 1);
+					indices.insert(indices.end(), { p10, p11, p01 });
+				}
+			}
+		}
+	}
+}
+
+void SphereGenerator::genCubeSphere(size_t resolution, std::vector<glm::vec3>& positions, std::vector<unsigned int>& indices)
+{
+	const int n = (int)std::max<size_t>(resolution, 1);
+
+	positions.clear();
+	indices.clear();
+	positions.reserve(6 * n * n + 2);
+	indices.reserve(3 * 12 * n * n);
+
+	// A point is identified by its integer coordinates on the [0, n] cube,
+	// so the points of the edges and corners shared between faces are only created once
+	std::unordered_map<unsigned long long, unsigned int> points;
+	auto point = [&](const int lattice[3]) -> unsigned int {
+		const unsigned long long key = ((unsigned long long)lattice[0] * (n + 1) + lattice[1]) * (n + 1) + lattice[2];
+		auto found = points.find(key);
+		if (found != points.end()) return found->second;
+
+		const glm::vec3 onCube = glm::vec3(lattice[0], lattice[1], lattice[2]) * (2.0f / n) - 1.0f;
+		const unsigned int index = (unsigned int)positions.size();
+		positions.push_back(glm::normalize(onCube));
+		points.emplace(key, index);
+		return index;
+	};
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		for (int side = 0; side <= 1; side++)
+		{
+			const int uAxis = (axis + 1) % 3, vAxis = (axis + 2) % 3;
+
+			// Corner (u, v) of the face
+			auto facePoint = [&](int u, int v) -> unsigned int {
+				int lattice[3];
+				lattice[axis] = side * n;
+				lattice[uAxis] = u;
+				lattice[vAxis] = v;
+				return point(lattice);
+			};
+
+			// The u and v axes are counter-clockwise on one side of the cube and clockwise on the other
+			bool flip = false;
+			for (int v = 0; v < n; v++)
+			{
+				for (int u = 0; u < n; u++)
+				{
+					const unsigned int p00 = facePoint(u, v), p10 = facePoint(u + 1, v);
+					const unsigned int p01 = facePoint(u, v + 1), p11 = facePoint(u + 1, v + 1);
+					if (u == 0 && v == 0) flip = !facesOutward(positions[p00], positions[p10], positions[p11]);
+
+					if (flip) indices.insert(indices.end(), { p00, p11, p10, p00, p01, p11 });
+					else indices.insert(indices.end(), { p00, p10, p11, p00, p11, p01 });
+				}
+			}
+		}
+	}
+}
+
+void SphereGenerator::defineEquirectangularTexCoords(std::vector<glm::vec3>& positions, std::vector<unsigned int>& indices, std::vector<glm::vec2>& texCoords)
+{
+	const float twoPi = 2.0f * 3.14159265358979f;
+	const float pi = 3.14159265358979f;
+
+	// The same mapping as UVSphere::generateBand(): u follows the longitude, v the colatitude
+	texCoords.resize(positions.size());
+	std::vector<bool> isPole(positions.size());
+	for (size_t i = 0; i < positions.size(); i++)
+	{
+		const glm::vec3 p = glm::normalize(positions[i]);
+		float u = std::atan2(p.y, p.x) / twoPi;
+		if (u < 0.0f) u += 1.0f;
+		texCoords[i] = glm::vec2(u, std::acos(glm::clamp(p.z, -1.0f, 1.0f)) / pi);
+		isPole[i] = p.x * p.x + p.y * p.y < 1e-10f; // The longitude is meaningless there
+	}
+
+	// Duplicates with u + 1 of the vertices on the u = 0 side of the seam, created on demand
+	std::vector<unsigned int> wrapped(positions.size(), 0);
+	std::vector<bool> poleUsed(positions.size(), false);
+
+	for (size_t triangle = 0; triangle < indices.size(); triangle += 3)
+	{
+		unsigned int* corners = &indices[triangle];
+
+		float uMin = 2.0f, uMax = -1.0f;
+		for (int k = 0; k < 3; k++)
+		{
+			if (isPole[corners[k]]) continue;
+			uMin = std::min(uMin, texCoords[corners[k]].x);
+			uMax = std::max(uMax, texCoords[corners[k]].x);
+		}
+
+		// A triangle cannot span half the longitudes, so it crosses the seam
+		if (uMax - uMin > 0.5f)
+		{
+			for (int k = 0; k < 3; k++)
+			{
+				const unsigned int vertex = corners[k];
+				if (isPole[vertex] || texCoords[vertex].x >= 0.5f) continue;
+
+				if (wrapped[vertex] == 0)
+				{
+					wrapped[vertex] = (unsigned int)positions.size();
+					positions.push_back(positions[vertex]);
+					texCoords.push_back(texCoords[vertex] + glm::vec2(1.0f, 0.0f));
+				}
+				corners[k] = wrapped[vertex];
+			}
+		}
+
+		// Each triangle gets its own pole vertex, in the middle of the longitudes of its other vertices
+		for (int k = 0; k < 3; k++)
+		{
+			const unsigned int vertex = corners[k];
+			if (vertex >= isPole.size() || !isPole[vertex]) continue; // Seam duplicates are never poles
+
+			const float u = (texCoords[corners[(k + 1) % 3]].x + texCoords[corners[(k + 2) % 3]].x) / 2.0f;
+			if (!poleUsed[vertex])
+			{
+				// The first triangle keeps the original vertex
+				poleUsed[vertex] = true;
+				texCoords[vertex].x = u;
+				continue;
+			}
+			corners[k] = (unsigned int)positions.size();
+			positions.push_back(positions[vertex]);
+			texCoords.push_back(glm::vec2(u, texCoords[vertex].y));
+		}
+	}
+}
@@ -0,0 +1,63 @@
+#ifndef INCLUDE_SPHEREGENERATOR
+#define INCLUDE_SPHEREGENERATOR
+
+#include <dep/glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+/*
+* @brief How the unit sphere is cut into triangles.
+*/
+enum SphereTopology
+{
+	UVSphere,   // Latitude/longitude grid, resolution is the amount of meridians and parallels
+	Icosphere,  // Subdivided icosahedron, resolution is the amount of segments each icosahedron edge is cut into
+	CubeSphere  // Normalized cube, resolution is the amount of quads along each cube edge
+};
+
+/*
+* @brief CPU-side generation of the unit sphere topologies that are not a latitude/longitude grid.
+*
+* The triangles are counter-clockwise seen from outside, like the ones of UVSphere.
+*/
+class SphereGenerator
+{
+public:
+	/*
+	* @brief Get the human readable name of a topology.
+	*/
+	static const char* getName(SphereTopology topology);
+
+	/*
+	* @brief Generates an icosphere, every vertex being shared by all its triangles.
+	*
+	* @param frequency The amount of segments each edge of the icosahedron is cut into, at least 1.
+	* @param positions Receives the vertices, on the unit sphere.
+	* @param indices Receives three indices per triangle.
+	*/
+	static void genIcosphere(size_t frequency, std::vector<glm::vec3>& positions, std::vector<unsigned int>& indices);
+
+	/*
+	* @brief Generates a normalized cube-sphere, every vertex being shared by all its triangles.
+	*
+	* @param resolution The amount of quads along each edge of the cube, at least 1.
+	* @param positions Receives the vertices, on the unit sphere.
+	* @param indices Receives three indices per triangle.
+	*/
+	static void genCubeSphere(size_t resolution, std::vector<glm::vec3>& positions, std::vector<unsigned int>& indices);
+
+	/*
+	* @brief Maps the equirectangular textures on a sphere, duplicating the vertices where the mapping is discontinuous.
+	*
+	* The triangles crossing the u = 0 meridian get u past 1 on their side of the seam (the textures repeat),
+	* and every triangle touching a pole gets its own pole vertex, with the u of the rest of the triangle.
+	*
+	* @param positions The vertices, mapped after their direction from the center. The duplicates are appended.
+	* @param indices Three indices per triangle, redirected to the duplicates.
+	* @param texCoords Receives one texture coordinate per vertex, u in [0, 2) and v in [0, 1], v = 0 at the north pole (+z).
+	*/
+	static void defineEquirectangularTexCoords(std::vector<glm::vec3>& positions, std::vector<unsigned int>& indices, std::vector<glm::vec2>& texCoords);
+};
+
+#endif
@@ -0,0 +1,51 @@
+#include "sphereLods.h"
+
+#include <cmath>
+
+// Largest silhouette error allowed, in pixels
+static const float kMaxSilhouetteError = 0.5f;
+
+// A coarser level is only used again once its error is below this fraction of kMaxSilhouetteError
+static const float kHysteresis = 0.5f;
+
+void SphereLods::init(const std::vector<size_t>& resolutions, ThreadPool* threadPool, const std::string& cacheDirectory)
+{
+	m_resolutions = resolutions;
+	m_levels.clear();
+	for (size_t resolution : resolutions)
+	{
+		std::shared_ptr<Mesh> level = Mesh::genSphere(resolution, false, UVSphere, threadPool, cacheDirectory);
+		level->defineRenderMethod();
+		m_levels.push_back(level);
+	}
+}
+
+float SphereLods::silhouetteError(size_t level, float projectedRadius) const
+{
+	// The silhouette is a polygon of `resolution` sides, its edges are chords of the circle
+	return projectedRadius * (1.0f - std::cos((float)M_PI / m_resolutions[level]));
+}
+
+int SphereLods::selectLevel(float projectedRadius, int currentLevel) const
+{
+	const int levelCount = (int)m_levels.size();
+
+	int ideal = levelCount - 1;
+	for (int level = 0; level < levelCount; level++)
+	{
+		if (silhouetteError(level, projectedRadius) <= kMaxSilhouetteError)
+		{
+			ideal = level;
+			break;
+		}
+	}
+
+	if (currentLevel < 0 || ideal >= currentLevel) return ideal;
+
+	// Only go coarser to a level that is fine enough by a margin
+	for (int level = ideal; level < currentLevel; level++)
+	{
+		if (silhouetteError(level, projectedRadius) <= kMaxSilhouetteError * kHysteresis) return level;
+	}
+	return currentLevel;
+}
@@ -0,0 +1,55 @@
+#ifndef INCLUDE_SPHERELODS
+#define INCLUDE_SPHERELODS
+
+#include "mesh.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+* @brief The same sphere at increasing resolutions, and the choice of the one to draw a body with.
+* 
+* A level is picked so that the silhouette of the body deviates from a true circle by less than
+* half a pixel, with some hysteresis so that a body on the edge of two levels does not pop.
+*/
+class SphereLods
+{
+public:
+	/*
+	* @brief Generates and sends to the GPU every level.
+	* 
+	* @param resolutions The resolution of each level, from the coarsest to the finest.
+	* @param threadPool The workers sharing the generation of the levels that are not baked, nullptr to generate them on the calling thread.
+	* @param cacheDirectory Where the levels that are not baked are saved once generated, and loaded from on the next runs. Empty to not use any.
+	*/
+	void init(const std::vector<size_t>& resolutions, ThreadPool* threadPool = nullptr, const std::string& cacheDirectory = "");
+
+	inline size_t getLevelCount() const { return m_levels.size(); }
+	inline const std::shared_ptr<Mesh>& getLevel(size_t level) const { return m_levels[level]; }
+	inline size_t getResolution(size_t level) const { return m_resolutions[level]; }
+
+	/*
+	* @brief Picks the level to draw a body with.
+	* 
+	* Going to a finer level happens as soon as the current one is not fine enough, going back to a
+	* coarser one only once it is fine enough by a good margin.
+	* 
+	* @param projectedRadius The radius of the body on screen, in pixels.
+	* @param currentLevel The level the body was drawn with last frame, negative if none.
+	* 
+	* @return The level to draw the body with.
+	*/
+	int selectLevel(float projectedRadius, int currentLevel) const;
+
+private:
+	std::vector<std::shared_ptr<Mesh>> m_levels;
+	std::vector<size_t> m_resolutions;
+
+	/*
+	* @brief The distance, in pixels, between the silhouette of a level and the true circle.
+	*/
+	float silhouetteError(size_t level, float projectedRadius) const;
+};
+
+#endif
@@ -0,0 +1,358 @@
+#include "sphereTerrain.h"
+#include "frameStats.h"
+#include "meshOptimizer.h"
+#include "sphereGenerator.h"
+
+#include <dep/glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <queue>
+#include <utility>
+
+// Quads along each edge of a chunk
+static const int kChunkGrid = 16;
+
+// Deepest level of the quadtree, the float positions of the chunks are not precise enough past it
+static const int kMaxLevel = 16;
+
+// Largest error allowed, in pixels, like SphereLods
+static const float kMaxScreenError = 0.5f;
+
+// At most this many chunks per body, about 750 triangles each
+static const size_t kMaxChunksPerBody = 384;
+
+// A body is drawn with the chunks once its radius on screen is this fraction of the viewport,
+// and its root chunks are requested at half of it
+static const float kMinProjectedRadius = 0.5f;
+
+// Chunks kept on the GPU, and chunks being generated, at most
+static const size_t kCacheCapacity = 2048;
+static const size_t kMaxPendingChunks = 32;
+
+// Generated chunks uploaded per frame, at most, so that the frame time stays steady
+static const int kMaxUploadsPerFrame = 8;
+
+// The skirts hide the cracks with neighbours up to two levels coarser
+static const float kSkirtErrorRatio = 16.0f;
+static const float kMaxSkirtDepth = 0.05f;
+
+SphereTerrain::SphereTerrain(std::shared_ptr<ThreadPool> threadPool)
+	: m_threadPool(threadPool)
+{
+}
+
+SphereTerrain::~SphereTerrain()
+{
+	for (std::pair<const ChunkKey, Chunk>& chunk : m_chunks)
+	{
+		release(chunk.second);
+	}
+}
+
+glm::vec3 SphereTerrain::faceDirection(int face, double s, double t)
+{
+	const int axis = face / 2;
+	double point[3];
+	point[axis] = face % 2 == 0 ? -1.0 : 1.0;
+	point[(axis + 1) % 3] = 2.0 * s - 1.0;
+	point[(axis + 2) % 3] = 2.0 * t - 1.0;
+
+	const double length = std::sqrt(point[0] * point[0] + point[1] * point[1] + point[2] * point[2]);
+	return glm::vec3(point[0] / length, point[1] / length, point[2] / length);
+}
+
+float SphereTerrain::geometricError(int level)
+{
+	// A quad spans at most this angle, at the center of a face, and its diagonal is sqrt(2) longer:
+	// the sagitta of the diagonal, 1 - cos(angle * sqrt(2) / 2), is about angle^2 / 4
+	const float angle = 2.0f / ((float)(1u << level) * kChunkGrid);
+	return angle * angle / 4.0f;
+}
+
+void SphereTerrain::getBounds(ChunkKey key, glm::vec3& center, float& radius)
+{
+	const int face = getFace(key);
+	const double cells = (double)(1u << getLevel(key));
+	const double x = getX(key), y = getY(key);
+
+	// The chunk is a convex spherical quad, its corners are the furthest from any point inside it
+	center = faceDirection(face, (x + 0.5) / cells, (y + 0.5) / cells);
+	radius = 0.0f;
+	for (int corner = 0; corner < 4; corner++)
+	{
+		const glm::vec3 direction = faceDirection(face, (x + corner % 2) / cells, (y + corner / 2) / cells);
+		radius = std::max(radius, glm::length(direction - center));
+	}
+	radius += std::min(kSkirtErrorRatio * geometricError(getLevel(key)), kMaxSkirtDepth);
+}
+
+// Whether the triangle a, b, c is counter-clockwise seen from outside a sphere centered at the origin
+static bool facesOutward(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+{
+	return glm::dot(glm::cross(b - a, c - a), a + b + c) > 0.0f;
+}
+
+SphereTerrain::ChunkData SphereTerrain::genChunk(ChunkKey key)
+{
+	const int face = getFace(key), level = getLevel(key);
+	const double cells = (double)(1u << level);
+	const double x = getX(key), y = getY(key);
+	const int rowSize = kChunkGrid + 1;
+
+	std::vector<glm::vec3> positions;
+	positions.reserve(rowSize * rowSize + 4 * kChunkGrid);
+	for (int j = 0; j <= kChunkGrid; j++)
+	{
+		for (int i = 0; i <= kChunkGrid; i++)
+		{
+			positions.push_back(faceDirection(face, (x + (double)i / kChunkGrid) / cells, (y + (double)j / kChunkGrid) / cells));
+		}
+	}
+
+	std::vector<unsigned int> indices;
+	indices.reserve(6 * kChunkGrid * kChunkGrid + 12 * 4 * kChunkGrid);
+
+	// Like the cube-sphere faces, the (i, j) axes are clockwise on half of the faces
+	const bool flip = !facesOutward(positions[0], positions[1], positions[rowSize + 1]);
+	for (int j = 0; j < kChunkGrid; j++)
+	{
+		for (int i = 0; i < kChunkGrid; i++)
+		{
+			const unsigned int p00 = j * rowSize + i, p10 = p00 + 1, p01 = p00 + rowSize, p11 = p01 + 1;
+			if (flip) indices.insert(indices.end(), { p00, p11, p10, p00, p01, p11 });
+			else indices.insert(indices.end(), { p00, p10, p11, p00, p11, p01 });
+		}
+	}
+
+	// The skirts hang from the border of the chunk towards the center of the sphere,
+	// filling the cracks along the neighbours of another level
+	std::vector<unsigned int> border;
+	border.reserve(4 * kChunkGrid);
+	for (int i = 0; i < kChunkGrid; i++) border.push_back(i);
+	for (int j = 0; j < kChunkGrid; j++) border.push_back(j * rowSize + kChunkGrid);
+	for (int i = kChunkGrid; i > 0; i--) border.push_back(kChunkGrid * rowSize + i);
+	for (int j = kChunkGrid; j > 0; j--) border.push_back(j * rowSize);
+
+	const float skirtDepth = std::min(kSkirtErrorRatio * geometricError(level), kMaxSkirtDepth);
+	const unsigned int firstSkirt = (unsigned int)positions.size();
+	for (unsigned int vertex : border)
+	{
+		positions.push_back(positions[vertex] * (1.0f - skirtDepth));
+	}
+	for (size_t k = 0; k < border.size(); k++)
+	{
+		const size_t next = (k + 1) % border.size();
+		const unsigned int a = border[k], b = border[next];
+		const unsigned int skirtA = firstSkirt + (unsigned int)k, skirtB = firstSkirt + (unsigned int)next;
+
+		// Both windings, so the skirts are not culled whichever side they are seen from
+		indices.insert(indices.end(), { a, skirtA, b, b, skirtA, skirtB, a, b, skirtA, b, skirtB, skirtA });
+	}
+
+	std::vector<glm::vec2> texCoords;
+	SphereGenerator::defineEquirectangularTexCoords(positions, indices, texCoords);
+	MeshOptimizer::optimizeVertexCache(indices, positions.size());
+
+	ChunkData data;
+	data.vertices.resize(positions.size());
+	for (size_t i = 0; i < positions.size(); i++)
+	{
+		data.vertices[i].position = positions[i];
+		data.vertices[i].normal = MeshUtility::packNormal(glm::normalize(positions[i]));
+		data.vertices[i].texCoord = MeshUtility::packTexCoord(texCoords[i]);
+	}
+	data.indices.assign(indices.begin(), indices.end());
+	return data;
+}
+
+SphereTerrain::Chunk* SphereTerrain::acquire(ChunkKey key)
+{
+	auto found = m_chunks.find(key);
+	if (found != m_chunks.end())
+	{
+		Chunk& chunk = found->second;
+		chunk.lastUsedFrame = m_frame;
+		m_lru.splice(m_lru.begin(), m_lru, chunk.lruPosition);
+		return &chunk;
+	}
+
+	// The most needed chunks are acquired first, the others will be requested again later
+	if (m_pending.size() < kMaxPendingChunks && m_pending.find(key) == m_pending.end())
+	{
+		m_pending.emplace(key, m_threadPool->submit([key]() { return genChunk(key); }));
+	}
+	return nullptr;
+}
+
+void SphereTerrain::upload(ChunkKey key, const ChunkData& data)
+{
+	Chunk chunk;
+	glGenVertexArrays(1, &chunk.vao);
+	glBindVertexArray(chunk.vao);
+
+	const size_t vertexBytes = sizeof(PackedVertex) * data.vertices.size();
+	glGenBuffers(1, &chunk.vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, chunk.vbo);
+	glBufferData(GL_ARRAY_BUFFER, vertexBytes, data.vertices.data(), GL_STATIC_DRAW);
+	Mesh::defineVertexAttributes();
+
+	// The per-instance attributes stay disabled, renderBody() sets their value for the whole draw
+	const size_t indexBytes = sizeof(GLushort) * data.indices.size();
+	glGenBuffers(1, &chunk.ibo);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, chunk.ibo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, data.indices.data(), GL_STATIC_DRAW);
+
+	glBindVertexArray(0); // Unbinding
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	FrameStats::current().bytesUploaded += vertexBytes + indexBytes;
+
+	chunk.indexCount = (GLsizei)data.indices.size();
+	chunk.lastUsedFrame = m_frame;
+	m_lru.push_front(key);
+	chunk.lruPosition = m_lru.begin();
+	m_chunks.emplace(key, chunk);
+}
+
+void SphereTerrain::release(Chunk& chunk)
+{
+	GLuint buffers[] = { chunk.vbo, chunk.ibo };
+	glDeleteBuffers(2, buffers);
+	glDeleteVertexArrays(1, &chunk.vao);
+}
+
+void SphereTerrain::update()
+{
+	m_frame++;
+	m_drawnChunkCount = 0;
+
+	int uploads = 0;
+	for (auto pending = m_pending.begin(); pending != m_pending.end() && uploads < kMaxUploadsPerFrame;)
+	{
+		if (pending->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			++pending;
+			continue;
+		}
+		upload(pending->first, pending->second.get());
+		uploads++;
+		pending = m_pending.erase(pending);
+	}
+
+	// The chunks used last frame are likely to be used again by this one, they are kept even over capacity
+	while (m_chunks.size() > kCacheCapacity)
+	{
+		const ChunkKey key = m_lru.back();
+		Chunk& chunk = m_chunks.at(key);
+		if (chunk.lastUsedFrame + 1 >= m_frame) break;
+
+		release(chunk);
+		m_chunks.erase(key);
+		m_lru.pop_back();
+	}
+}
+
+bool SphereTerrain::renderBody(const Body& body, const Camera& camera, const Frustum& frustum, float viewportHeight)
+{
+	const glm::vec3 bodyCenter = body.getSelfCenter();
+	const float bodyRadius = body.getRadius();
+	const float projectedRadius = camera.computeProjectedRadius(bodyCenter, bodyRadius, viewportHeight);
+	if (projectedRadius < 0.5f * kMinProjectedRadius * viewportHeight) return false;
+
+	bool rootsReady = true;
+	for (int face = 0; face < 6; face++)
+	{
+		if (acquire(makeKey(face, 0, 0, 0)) == nullptr) rootsReady = false;
+	}
+	if (!rootsReady || projectedRadius < kMinProjectedRadius * viewportHeight) return false;
+
+	const MeshInstance instance = body.getInstance();
+	const glm::vec3 cameraPosition = camera.getPosition();
+	const glm::vec3 toCamera = cameraPosition - bodyCenter;
+	const float cameraDistance = glm::length(toCamera);
+
+	// The screen error of a chunk, negative if it cannot be seen
+	auto screenError = [&](ChunkKey key) -> float {
+		glm::vec3 localCenter;
+		float localRadius;
+		getBounds(key, localCenter, localRadius);
+
+		const glm::vec3 center = glm::vec3(instance.modelMatrix * glm::vec4(localCenter, 1.0f));
+		const float radius = localRadius * bodyRadius;
+		if (!frustum.intersectsSphere(center, radius)) return -1.0f;
+
+		// Behind the horizon when even the point of the chunk facing the camera the most faces away from it
+		if (cameraDistance > bodyRadius)
+		{
+			const float chunkAngle = 2.0f * std::asin(std::min(localRadius / 2.0f, 1.0f));
+			const float cameraAngle = std::acos(glm::clamp(glm::dot(glm::normalize(center - bodyCenter), toCamera / cameraDistance), -1.0f, 1.0f));
+			if (cameraDistance * std::cos(std::max(cameraAngle - chunkAngle, 0.0f)) < bodyRadius * (1.0f - kMaxSkirtDepth)) return -1.0f;
+		}
+
+		const float distance = std::max(glm::length(center - cameraPosition) - radius, camera.getNear());
+		return camera.computeProjectedSize(geometricError(getLevel(key)) * bodyRadius, distance, viewportHeight);
+	};
+
+	// The chunk with the largest error is split first, until every error is small enough or the budget is spent
+	std::priority_queue<std::pair<float, ChunkKey>> candidates;
+	for (int face = 0; face < 6; face++)
+	{
+		const ChunkKey root = makeKey(face, 0, 0, 0);
+		const float error = screenError(root);
+		if (error >= 0.0f) candidates.push(std::make_pair(error, root));
+	}
+
+	m_selection.clear();
+	while (!candidates.empty())
+	{
+		const std::pair<float, ChunkKey> candidate = candidates.top();
+		candidates.pop();
+
+		const ChunkKey key = candidate.second;
+		const int level = getLevel(key);
+		bool split = candidate.first > kMaxScreenError && level < kMaxLevel
+			&& m_selection.size() + candidates.size() + 4 <= kMaxChunksPerBody;
+
+		if (split)
+		{
+			// The children are only used once the four of them are ready, the parent is drawn meanwhile
+			ChunkKey children[4];
+			for (int child = 0; child < 4; child++)
+			{
+				children[child] = makeKey(getFace(key), level + 1, 2 * getX(key) + child % 2, 2 * getY(key) + child / 2);
+				if (acquire(children[child]) == nullptr) split = false;
+			}
+
+			if (split)
+			{
+				for (ChunkKey child : children)
+				{
+					const float error = screenError(child);
+					if (error >= 0.0f) candidates.push(std::make_pair(error, child));
+				}
+				continue;
+			}
+		}
+		m_selection.push_back(key);
+	}
+
+	// Like the instanced draws, without the instance stream: the per-instance attributes are constant
+	for (int column = 0; column < 4; column++)
+	{
+		glVertexAttrib4fv(5 + column, glm::value_ptr(instance.modelMatrix[column]));
+	}
+	glVertexAttrib1f(9, instance.textureLayer);
+	glVertexAttrib1f(10, instance.emissive);
+
+	for (ChunkKey key : m_selection)
+	{
+		const Chunk& chunk = m_chunks.at(key);
+		glBindVertexArray(chunk.vao);
+		glDrawElements(GL_TRIANGLES, chunk.indexCount, GL_UNSIGNED_SHORT, 0);
+	}
+	glBindVertexArray(0); // Unbinding
+
+	m_drawnChunkCount += m_selection.size();
+	return true;
+}
@@ -0,0 +1,159 @@
+#ifndef INCLUDE_SPHERETERRAIN
+#define INCLUDE_SPHERETERRAIN
+
+#include "body.h"
+#include "camera.h"
+#include "frustum.h"
+#include "mesh.h"
+#include "threadPool.h"
+
+#include <dep/glm/glm.hpp>
+
+#include <glad/gl.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+/*
+* @brief Cube-sphere quadtree of chunks, refined near the camera, for the bodies seen from close.
+*
+* Each face of the cube is split in four, recursively, and each node of the quadtree is a chunk: a grid
+* of the same amount of quads projected on the unit sphere. The chunks of a body are picked every frame
+* so that none has an error above half a pixel, within a budget, and only the visible ones are drawn.
+*
+* The chunks are in local space, hence shared by every body. They are generated on the worker threads,
+* uploaded by the main thread, and kept in a least recently used cache.
+*/
+class SphereTerrain
+{
+public:
+	/*
+	* @param threadPool The workers generating the chunks.
+	*/
+	explicit SphereTerrain(std::shared_ptr<ThreadPool> threadPool);
+
+	SphereTerrain(const SphereTerrain&) = delete;
+	SphereTerrain& operator=(const SphereTerrain&) = delete;
+
+	/*
+	* @brief Frees the GPU buffers of the cached chunks.
+	*/
+	~SphereTerrain();
+
+	/*
+	* @brief Uploads some of the chunks generated since the last call, and evicts the least recently used ones.
+	* Called once per frame, before the bodies are drawn.
+	*/
+	void update();
+
+	/*
+	* @brief Draws a body with the chunks, if it is close enough to need them and they are ready.
+	*
+	* The GPU program must be in use, and the body texture array bound.
+	*
+	* @param body The body to draw.
+	* @param camera The camera the body is seen from.
+	* @param frustum The frustum of the camera.
+	* @param viewportHeight The height of the viewport, in pixels.
+	*
+	* @return Whether the body has been drawn. If not, it must be drawn with its Mesh.
+	*/
+	bool renderBody(const Body& body, const Camera& camera, const Frustum& frustum, float viewportHeight);
+
+	/*
+	* @brief Get the amount of chunks drawn since the last update().
+	*/
+	inline size_t getDrawnChunkCount() const { return m_drawnChunkCount; }
+
+private:
+	// Face (3 bits), level (5 bits), then the x and y of the chunk on its face (24 bits each)
+	typedef std::uint64_t ChunkKey;
+
+	// A chunk as generated by the workers
+	struct ChunkData
+	{
+		std::vector<PackedVertex> vertices;
+		std::vector<GLushort> indices;
+	};
+
+	// A chunk on the GPU
+	struct Chunk
+	{
+		GLuint vao = 0, vbo = 0, ibo = 0;
+		GLsizei indexCount = 0;
+		size_t lastUsedFrame = 0;
+		std::list<ChunkKey>::iterator lruPosition;
+	};
+
+	std::shared_ptr<ThreadPool> m_threadPool;
+
+	std::unordered_map<ChunkKey, Chunk> m_chunks;
+	std::list<ChunkKey> m_lru; // Most recently used first
+
+	// Chunks being generated
+	std::unordered_map<ChunkKey, std::future<ChunkData>> m_pending;
+
+	size_t m_frame = 0;
+	size_t m_drawnChunkCount = 0;
+
+	// Reused every frame
+	std::vector<ChunkKey> m_selection;
+
+	inline static ChunkKey makeKey(int face, int level, std::uint32_t x, std::uint32_t y)
+	{
+		return ((ChunkKey)face << 61) | ((ChunkKey)level << 56) | ((ChunkKey)x << 24) | (ChunkKey)y;
+	}
+
+	inline static int getFace(ChunkKey key) { return (int)(key >> 61); }
+	inline static int getLevel(ChunkKey key) { return (int)((key >> 56) & 0x1F); }
+	inline static std::uint32_t getX(ChunkKey key) { return (std::uint32_t)((key >> 24) & 0xFFFFFF); }
+	inline static std::uint32_t getY(ChunkKey key) { return (std::uint32_t)(key & 0xFFFFFF); }
+
+	/*
+	* @brief Get the direction, from the center of the sphere, of a point of a face of the cube.
+	*
+	* @param face The face of the cube.
+	* @param s The first coordinate on the face, in [0, 1].
+	* @param t The second coordinate on the face, in [0, 1].
+	*/
+	static glm::vec3 faceDirection(int face, double s, double t);
+
+	/*
+	* @brief Get the largest distance between a chunk and the sphere, in sphere radii.
+	*/
+	static float geometricError(int level);
+
+	/*
+	* @brief Get the sphere bounding a chunk, skirts included, in local space.
+	*/
+	static void getBounds(ChunkKey key, glm::vec3& center, float& radius);
+
+	/*
+	* @brief Generates the vertices and triangles of a chunk. Runs on the workers.
+	*/
+	static ChunkData genChunk(ChunkKey key);
+
+	/*
+	* @brief Get a chunk if it is on the GPU, and mark it as used this frame. Otherwise queue its generation.
+	*
+	* @return The chunk, nullptr if it is not ready.
+	*/
+	Chunk* acquire(ChunkKey key);
+
+	/*
+	* @brief Sends a generated chunk to the GPU, and adds it to the cache.
+	*/
+	void upload(ChunkKey key, const ChunkData& data);
+
+	/*
+	* @brief Frees the GPU buffers of a chunk.
+	*/
+	static void release(Chunk& chunk);
+};
+
+#endif
@@ -0,0 +1,114 @@
+#include "streamBuffer.h"
+#include "frameStats.h"
+#include "glExtensions.h"
+
+StreamBuffer::StreamBuffer(GLenum target) :
+	m_target(target)
+{
+}
+
+StreamBuffer::~StreamBuffer()
+{
+	for (int region = 0; region < kRegionCount; region++)
+	{
+		if (m_fences[region]) glDeleteSync(m_fences[region]);
+	}
+
+	if (m_buffer == 0) return; // Never used
+
+	if (m_persistentPointer)
+	{
+		glBindBuffer(m_target, m_buffer);
+		glUnmapBuffer(m_target);
+	}
+	glDeleteBuffers(1, &m_buffer);
+}
+
+void StreamBuffer::allocate(size_t regionSize)
+{
+	// Every region the GPU may still read is about to be freed
+	for (int region = 0; region < kRegionCount; region++) waitForRegion(region);
+
+	// Grow geometrically, and keep the region offsets aligned for any attribute type
+	size_t newSize = 256;
+	while (newSize < regionSize) newSize *= 2;
+	m_regionSize = newSize;
+	const GLsizeiptr totalSize = (GLsizeiptr)(m_regionSize * kRegionCount);
+
+	if (m_persistentPointer)
+	{
+		glBindBuffer(m_target, m_buffer);
+		glUnmapBuffer(m_target);
+		m_persistentPointer = nullptr;
+	}
+
+	if (GLExtensions::hasBufferStorage())
+	{
+		// Immutable storage cannot be resized, a new buffer is needed
+		if (m_buffer) glDeleteBuffers(1, &m_buffer);
+		glGenBuffers(1, &m_buffer);
+		glBindBuffer(m_target, m_buffer);
+
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		GLExtensions::bufferStorage(m_target, totalSize, nullptr, flags);
+		m_persistentPointer = (char*)glMapBufferRange(m_target, 0, totalSize, flags);
+	}
+	else
+	{
+		if (!m_buffer) glGenBuffers(1, &m_buffer);
+		glBindBuffer(m_target, m_buffer);
+		glBufferData(m_target, totalSize, nullptr, GL_STREAM_DRAW);
+	}
+
+	m_region = kRegionCount - 1;
+}
+
+void StreamBuffer::waitForRegion(int region)
+{
+	GLsync& fence = m_fences[region];
+	if (!fence) return;
+
+	// Only flush the first time, waiting again does not need more commands to be sent
+	GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+	while (true)
+	{
+		const GLenum result = glClientWaitSync(fence, flags, 1000000); // 1 ms
+		if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED || result == GL_WAIT_FAILED) break;
+		flags = 0;
+	}
+
+	glDeleteSync(fence);
+	fence = nullptr;
+}
+
+void* StreamBuffer::map(size_t bytes)
+{
+	if (m_buffer == 0 || bytes > m_regionSize) allocate(bytes);
+
+	m_region = (m_region + 1) % kRegionCount;
+	waitForRegion(m_region);
+
+	m_mappedBytes = bytes;
+	const GLintptr offset = (GLintptr)(m_region * m_regionSize);
+	if (m_persistentPointer) return m_persistentPointer + offset;
+
+	// The fence guarantees the GPU is done with the region, so the driver does not need to check it
+	glBindBuffer(m_target, m_buffer);
+	return glMapBufferRange(m_target, offset, (GLsizeiptr)m_regionSize,
+		GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+}
+
+GLintptr StreamBuffer::unmap()
+{
+	glBindBuffer(m_target, m_buffer);
+	if (!m_persistentPointer) glUnmapBuffer(m_target);
+
+	FrameStats::current().bytesStreamed += m_mappedBytes;
+	return (GLintptr)(m_region * m_regionSize);
+}
+
+void StreamBuffer::fence()
+{
+	if (m_fences[m_region]) glDeleteSync(m_fences[m_region]);
+	m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
@@ -0,0 +1,82 @@
+#ifndef INCLUDE_STREAMBUFFER
+#define INCLUDE_STREAMBUFFER
+
+#include <glad/gl.h>
+
+#include <cstddef>
+
+/*
+* @brief Triple-buffered GPU buffer for the data rewritten every frame.
+* 
+* Each map() writes a region the GPU is done reading from: a fence placed after the draw calls
+* reading a region is waited on before the region is written again, so the driver never has to
+* stall on an implicit synchronization. The buffer is persistently mapped when the context
+* supports GL_ARB_buffer_storage, and mapped unsynchronized region by region otherwise (GL 3.3).
+*/
+class StreamBuffer
+{
+public:
+	/*
+	* @brief No GL object is created until the first map().
+	* 
+	* @param target The binding point of the buffer, e.g. GL_ARRAY_BUFFER.
+	*/
+	explicit StreamBuffer(GLenum target = GL_ARRAY_BUFFER);
+
+	StreamBuffer(const StreamBuffer&) = delete;
+	StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+	~StreamBuffer();
+
+	/*
+	* @brief Gives access to the next region, waiting for the GPU to be done with it if needed.
+	* 
+	* @param bytes The amount of bytes that will be written. The buffer grows if needed.
+	* 
+	* @return The pointer to write the data to, valid until unmap().
+	*/
+	void* map(size_t bytes);
+
+	/*
+	* @brief Hands the region written since map() to the GPU.
+	* 
+	* @return The offset of the region in the buffer, to use in glVertexAttribPointer & co.
+	*/
+	GLintptr unmap();
+
+	/*
+	* @brief Marks the current region as in use until the draw calls issued so far are done.
+	* To call after the draw calls reading the region.
+	*/
+	void fence();
+
+	/*
+	* @brief Get the GL buffer, bound to the target once mapped.
+	*/
+	inline GLuint getBuffer() const { return m_buffer; }
+
+private:
+	static const int kRegionCount = 3;
+
+	GLenum m_target;
+	GLuint m_buffer = 0;
+	size_t m_regionSize = 0;
+	int m_region = kRegionCount - 1;
+	size_t m_mappedBytes = 0;
+	GLsync m_fences[kRegionCount] = {};
+
+	// Only set when persistently mapped
+	char* m_persistentPointer = nullptr;
+
+	/*
+	* @brief (Re)creates the GL buffer with regions of at least the given size.
+	*/
+	void allocate(size_t regionSize);
+
+	/*
+	* @brief Blocks until the GPU is done with a region.
+	*/
+	void waitForRegion(int region);
+};
+
+#endif
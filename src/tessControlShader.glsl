@@ -0,0 +1,54 @@
+#version 400 core            // Tessellation needs OpenGL 4.0
+
+// Cuts each edge of a patch so that its pieces are about edgePixels long on screen
+layout(vertices = 3) out;
+
+in vec3 tcPosition[];
+in vec2 tcTexCoord[];
+in mat4 tcModelMat[];
+in float tcTextureLayer[];
+in float tcEmissive[];
+
+out vec3 tePosition[];
+out vec2 teTexCoord[];
+patch out mat4 teModelMat;
+patch out float teTextureLayer;
+patch out float teEmissive;
+
+uniform mat4 projMat;
+uniform vec3 camPos;
+uniform float viewportHeight; // In pixels
+uniform float edgePixels;     // Length on screen of the pieces of the edges
+
+// The least value of GL_MAX_TESS_GEN_LEVEL
+const float kMaxLevel = 64.0;
+
+// Tessellation level of the edge between two corners, in world space
+// The two patches sharing an edge compute the same level from the same corners, so no crack opens between them
+float edgeLevel(vec3 a, vec3 b) {
+        // The edge is measured as the diameter of a sphere around it, so that its level does not depend on its orientation
+        float distanceToCamera = max(distance(0.5 * (a + b), camPos), 1e-6);
+        float pixels = distance(a, b) * projMat[1][1] * 0.5 * viewportHeight / distanceToCamera;
+        return clamp(pixels / edgePixels, 1.0, kMaxLevel);
+}
+
+void main() {
+        tePosition[gl_InvocationID] = tcPosition[gl_InvocationID];
+        teTexCoord[gl_InvocationID] = tcTexCoord[gl_InvocationID];
+
+        if (gl_InvocationID == 0) {
+                teModelMat = tcModelMat[0];
+                teTextureLayer = tcTextureLayer[0];
+                teEmissive = tcEmissive[0];
+
+                vec3 p0 = (tcModelMat[0] * vec4(tcPosition[0], 1.0)).xyz;
+                vec3 p1 = (tcModelMat[0] * vec4(tcPosition[1], 1.0)).xyz;
+                vec3 p2 = (tcModelMat[0] * vec4(tcPosition[2], 1.0)).xyz;
+
+                // Outer level i is the one of the edge facing corner i
+                gl_TessLevelOuter[0] = edgeLevel(p1, p2);
+                gl_TessLevelOuter[1] = edgeLevel(p2, p0);
+                gl_TessLevelOuter[2] = edgeLevel(p0, p1);
+                gl_TessLevelInner[0] = max(max(gl_TessLevelOuter[0], gl_TessLevelOuter[1]), gl_TessLevelOuter[2]);
+        }
+}
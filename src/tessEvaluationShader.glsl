@@ -0,0 +1,46 @@
+#version 400 core            // Tessellation needs OpenGL 4.0
+
+// Places the vertices generated in a patch back on the unit sphere, counter-clockwise like the patch
+layout(triangles, fractional_odd_spacing, ccw) in;
+
+in vec3 tePosition[];
+in vec2 teTexCoord[];
+patch in mat4 teModelMat;
+patch in float teTextureLayer;
+patch in float teEmissive;
+
+// Sent to fragmentShader
+out vec3 fPosition;
+out vec3 fNormal;
+out vec2 fTexCoord;
+flat out float fTextureLayer;
+flat out float fEmissive;
+
+uniform mat4 viewMat, projMat;
+
+const float kPi = 3.14159265358979;
+
+void main() {
+        // precise: the two patches sharing an edge must compute bit-identical vertices along it
+        precise vec3 flatPosition = gl_TessCoord.x * tePosition[0] + gl_TessCoord.y * tePosition[1] + gl_TessCoord.z * tePosition[2];
+        vec3 localPosition = normalize(flatPosition);
+
+        // The equirectangular mapping of the direction, u being kept on the side of the seam of the patch corners
+        // At the poles u is undefined, the interpolated one is kept
+        vec2 texCoord = gl_TessCoord.x * teTexCoord[0] + gl_TessCoord.y * teTexCoord[1] + gl_TessCoord.z * teTexCoord[2];
+        if (abs(localPosition.z) < 0.99999) {
+                float u = atan(localPosition.y, localPosition.x) / (2.0 * kPi);
+                texCoord.x = u + round(texCoord.x - u);
+        }
+        texCoord.y = acos(clamp(localPosition.z, -1.0, 1.0)) / kPi;
+
+        vec4 worldPosition = teModelMat * vec4(localPosition, 1.0);
+        gl_Position = projMat * viewMat * worldPosition;
+
+        fPosition = worldPosition.xyz;
+        fNormal = normalize(mat3(teModelMat) * localPosition); // On the unit sphere, the normal is the position itself
+
+        fTexCoord = texCoord;
+        fTextureLayer = teTextureLayer;
+        fEmissive = teEmissive;
+}
@@ -0,0 +1,24 @@
+#version 400 core            // Tessellation needs OpenGL 4.0
+
+// The corners of the patches of the base mesh, in local space, passed as they are to tessControlShader
+layout(location=0) in vec3 vPosition;
+layout(location=4) in vec2 vTexCoord; // Packed as normalized unsigned shorts, u halved
+
+// Per-instance attributes, one set per body
+layout(location=5) in mat4 vModelMat; // Takes locations 5 to 8
+layout(location=9) in float vTextureLayer;
+layout(location=10) in float vEmissive;
+
+out vec3 tcPosition;
+out vec2 tcTexCoord;
+out mat4 tcModelMat;
+out float tcTextureLayer;
+out float tcEmissive;
+
+void main() {
+        tcPosition = vPosition;
+        tcTexCoord = vTexCoord * vec2(2.0, 1.0);
+        tcModelMat = vModelMat;
+        tcTextureLayer = vTextureLayer;
+        tcEmissive = vEmissive;
+}
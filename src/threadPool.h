@@ -0,0 +1,105 @@
+#ifndef INCLUDE_THREADPOOL
+#define INCLUDE_THREADPOOL
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/*
+* @brief Fixed set of worker threads running the tasks submitted to it, in submission order.
+*
+* The tasks must not touch the OpenGL context, which belongs to the main thread.
+*/
+class ThreadPool
+{
+public:
+	/*
+	* @brief Starts the workers.
+	*
+	* @param threadCount The amount of workers, 0 to leave one hardware thread to the main thread.
+	*/
+	explicit ThreadPool(size_t threadCount = 0);
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	/*
+	* @brief Stops the workers once their current task is done. The tasks not started yet are dropped.
+	*/
+	~ThreadPool();
+
+	inline size_t getThreadCount() const { return m_threads.size(); }
+
+	/*
+	* @brief Queues a task for the workers.
+	*
+	* @param task The function to run, without parameters.
+	*
+	* @return The result of the task, once it has run.
+	*/
+	template <typename F>
+	std::future<std::invoke_result_t<F>> submit(F task)
+	{
+		typedef std::invoke_result_t<F> Result;
+
+		// std::function must be copyable, std::packaged_task is not
+		std::shared_ptr<std::packaged_task<Result()>> packagedTask = std::make_shared<std::packaged_task<Result()>>(std::move(task));
+		std::future<Result> result = packagedTask->get_future();
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_tasks.push([packagedTask]() { (*packagedTask)(); });
+		}
+		m_taskAvailable.notify_one();
+		return result;
+	}
+
+	/*
+	* @brief Runs a function on every index of a range on the workers, and waits for all of them.
+	*
+	* The range is cut in contiguous parts, a few per worker to even the load. Must not be called from a task.
+	*
+	* @param count The amount of indices, from 0.
+	* @param function The function to run, taking the index as a size_t.
+	*/
+	template <typename F>
+	void parallelFor(size_t count, F function)
+	{
+		const size_t partCount = std::min(count, 4 * getThreadCount());
+		std::vector<std::future<void>> parts;
+		parts.reserve(partCount);
+		for (size_t part = 0; part < partCount; part++)
+		{
+			const size_t first = count * part / partCount, last = count * (part + 1) / partCount;
+			parts.push_back(submit([first, last, &function]() {
+				for (size_t i = first; i < last; i++) function(i);
+			}));
+		}
+
+		// Every part must be done before returning, function is referenced by them
+		// get() then rethrows the exceptions of the tasks
+		for (std::future<void>& part : parts) part.wait();
+		for (std::future<void>& part : parts) part.get();
+	}
+
+private:
+	std::vector<std::thread> m_threads;
+	std::queue<std::function<void()>> m_tasks;
+	std::mutex m_mutex;
+	std::condition_variable m_taskAvailable;
+	bool m_stopping = false;
+
+	/*
+	* @brief Loop of each worker, running the queued tasks until the pool stops.
+	*/
+	void work();
+};
+
+#endif
@@ -0,0 +1,12 @@
+#version 330 core	     // Minimal GL version support expected from the GPU
+
+uniform vec3 trailColor;
+
+in float fAge;
+
+out vec4 color; // Shader output: the color response attached to this fragment
+
+void main() {
+	// Fades out linearly, so that the end of a full ring does not pop when it moves
+	color = vec4(trailColor, 1.0 - fAge);
+}
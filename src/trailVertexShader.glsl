@@ -0,0 +1,21 @@
+#version 330 core            // Minimal GL version support expected from the GPU
+
+// No vertex attribute: gl_InstanceID is the trail, gl_VertexID the age of the point, 0 being the newest
+
+// rowCount rows of trailCount points, the row head holding the newest ones
+uniform samplerBuffer points;
+uniform int head;
+uniform int rowCount;
+uniform int trailCount;
+
+uniform mat4 viewMat, projMat;
+
+out float fAge; // 0 for the newest point, 1 for the oldest one the ring can hold
+
+void main() {
+	int row = (head - gl_VertexID + rowCount) % rowCount;
+	vec3 position = texelFetch(points, row * trailCount + gl_InstanceID).xyz;
+	gl_Position = projMat * viewMat * vec4(position, 1.0);
+
+	fAge = float(gl_VertexID) / float(rowCount - 1);
+}
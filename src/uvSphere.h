@@ -0,0 +1,183 @@
+#ifndef INCLUDE_UVSPHERE
+#define INCLUDE_UVSPHERE
+
+#include "meshUtility.h"
+
+#include <dep/glm/glm.hpp>
+
+#include <cstddef>
+
+/*
+* @brief Latitude/longitude sphere of radius 1 centered at (0,0,0), generated by constexpr code.
+*
+* The same functions generate the meshes baked into the binary at build time and the other ones at runtime,
+* so both are bit-identical. At runtime, the bands can be spread over a ThreadPool.
+*/
+class UVSphere
+{
+public:
+	// Quad rows drawn side by side before moving to the next column, sized for a 16 entries vertex cache
+	static constexpr size_t kBandRows = 6;
+
+	/*
+	* @brief Get the amount of vertices, the north and south poles, and size + 1 per parallel (the seam is doubled).
+	*/
+	constexpr static size_t vertexCount(size_t resolution)
+	{
+		return (resolution + 1) * (resolution - 2) + 2;
+	}
+
+	/*
+	* @brief Get the amount of indices of the triangle list.
+	*/
+	constexpr static size_t indexCount(size_t resolution)
+	{
+		return 3 * 2 * resolution * (resolution - 2);
+	}
+
+	/*
+	* @brief Get the amount of bands, each of kBandRows quad rows (the last one may have less).
+	*/
+	constexpr static size_t bandCount(size_t resolution)
+	{
+		return (resolution - 1 + kBandRows - 1) / kBandRows;
+	}
+
+	/*
+	* @brief Generates the vertices and triangles.
+	*
+	* @param resolution The amount of points used to approximate a disk, and also amount of disks.
+	* @param vertices Receives vertexCount(resolution) vertices.
+	* @param indices Receives indexCount(resolution) indices, counter-clockwise seen from outside.
+	*/
+	template <typename Index>
+	constexpr static void generate(size_t resolution, PackedVertex* vertices, Index* indices)
+	{
+		for (size_t band = 0; band < bandCount(resolution); band++)
+		{
+			generateBand(resolution, band, vertices, indices);
+		}
+	}
+
+	/*
+	* @brief Generates the part of the vertices and triangles belonging to a band.
+	*
+	* Every band writes at its own offsets, computed from its number only, so they can be generated in any order and in parallel.
+	* A band holds kBandRows parallels, the poles, and the triangles of kBandRows quad rows. Those come
+	* column after column, so that each column reuses the vertices of the previous one from the vertex cache.
+	* No reordering is needed afterwards.
+	*
+	* @param resolution The amount of points used to approximate a disk, and also amount of disks.
+	* @param band The band to generate, less than bandCount(resolution).
+	* @param vertices Where the vertexCount(resolution) vertices are.
+	* @param indices Where the indexCount(resolution) indices are, counter-clockwise seen from outside.
+	*/
+	template <typename Index>
+	constexpr static void generateBand(size_t resolution, size_t band, PackedVertex* vertices, Index* indices)
+	{
+		const size_t rowSize = resolution + 1;
+		const size_t count = vertexCount(resolution);
+		const size_t parallels = resolution - 2, quadRows = resolution - 1;
+
+		// North point
+		if (band == 0) setVertex(vertices[0], 0.0f, 0.0f, 1.0f, 0.5f, 0.0f);
+
+		// Parallel p (0-indexed, the poles apart) is at theta index p + 1
+		const size_t firstParallel = band * kBandRows;
+		const size_t lastParallel = firstParallel + kBandRows < parallels ? firstParallel + kBandRows : parallels;
+		for (size_t parallel = firstParallel; parallel < lastParallel; parallel++)
+		{
+			const size_t thetaIndex = parallel + 1;
+			const double theta = kPi * thetaIndex / (resolution - 1); // 0-indexing => size differs
+			const float sinTheta = (float)sine(theta), cosTheta = (float)cosine(theta);
+
+			size_t i = 1 + parallel * rowSize;
+			for (size_t phiIndex = 0; phiIndex < rowSize; phiIndex++, i++)
+			{
+				// The last point of the parallel is exactly the first one, its copy for the seam
+				const double phi = 2.0 * kPi * (phiIndex % resolution) / resolution;
+				const float x = sinTheta * (float)cosine(phi);
+				const float y = sinTheta * (float)sine(phi);
+				setVertex(vertices[i], x, y, cosTheta, (float)phiIndex / resolution, (float)thetaIndex / (resolution - 1));
+			}
+		}
+
+		// South point
+		if (band == bandCount(resolution) - 1) setVertex(vertices[count - 1], 0.0f, 0.0f, -1.0f, 0.5f, 1.0f);
+
+		// Quad row 0 is the northern fan, quad row resolution - 2 the southern one, and quad row q
+		// in between joins the parallels q - 1 and q
+		// The fans have one triangle per column, the other quad rows two
+		const size_t firstRow = band * kBandRows;
+		const size_t lastRow = firstRow + kBandRows < quadRows ? firstRow + kBandRows : quadRows;
+		const size_t north = 0, south = count - 1;
+		size_t index = firstRow == 0 ? 0 : 3 * resolution + (firstRow - 1) * 6 * resolution;
+		for (size_t column = 0; column < resolution; column++)
+		{
+			for (size_t row = firstRow; row < lastRow; row++)
+			{
+				if (row == 0)
+				{
+					const size_t left = 1 + column;
+					setTriangle(indices, index, north, left, left + 1);
+				}
+				else if (row == quadRows - 1)
+				{
+					const size_t left = 1 + (resolution - 3) * rowSize + column;
+					setTriangle(indices, index, south, left + 1, left);
+				}
+				else
+				{
+					const size_t upperLeft = 1 + (row - 1) * rowSize + column, lowerLeft = upperLeft + rowSize;
+					setTriangle(indices, index, upperLeft, lowerLeft, upperLeft + 1);
+					setTriangle(indices, index, upperLeft + 1, lowerLeft, lowerLeft + 1);
+				}
+			}
+		}
+	}
+
+private:
+	static constexpr double kPi = 3.14159265358979323846;
+
+	// std::sin() and std::cos() cannot be evaluated at build time
+	// Taylor series of sin(x) for x in [-pi, pi], exact to the double precision
+	constexpr static double taylorSine(double x)
+	{
+		double term = x, sum = x;
+		for (int n = 1; n < 14; n++)
+		{
+			term *= -x * x / ((2.0 * n) * (2.0 * n + 1.0));
+			sum += term;
+		}
+		return sum;
+	}
+
+	// For angles in [0, 2 pi]
+	constexpr static double sine(double x)
+	{
+		return taylorSine(x > kPi ? x - 2.0 * kPi : x);
+	}
+
+	constexpr static double cosine(double x)
+	{
+		return sine(x + kPi / 2.0 > 2.0 * kPi ? x - 1.5 * kPi : x + kPi / 2.0);
+	}
+
+	// On the unit sphere, the normal is the position itself
+	constexpr static void setVertex(PackedVertex& vertex, float x, float y, float z, float u, float v)
+	{
+		vertex.position = glm::vec3(x, y, z);
+		vertex.normal = MeshUtility::packNormal(x, y, z);
+		vertex.texCoord = MeshUtility::packTexCoord(u, v);
+	}
+
+	template <typename Index>
+	constexpr static void setTriangle(Index* indices, size_t& index, size_t pt1, size_t pt2, size_t pt3)
+	{
+		indices[index++] = (Index)pt1;
+		indices[index++] = (Index)pt2;
+		indices[index++] = (Index)pt3;
+	}
+};
+
+#endif
@@ -0,0 +1,201 @@
+#include "vertexKernel.h"
+#include "cpuFeatures.h"
+
+#include <cmath>
+
+// Have a very, very slight luminous intensity drop off the further out we go, see shadeBody() in lighting.glsl
+// pow(length, 0.125) is computed as three square roots, which the SIMD units do natively
+static const float kLightScale = 1.33203125f;
+
+void VertexSoA::resize(size_t count)
+{
+	m_count = count;
+	const size_t padded = (count + 7) & ~(size_t)7;
+	x.resize(padded, 0.0f);
+	y.resize(padded, 0.0f);
+	z.resize(padded, 0.0f);
+}
+
+static void transformScalar(const glm::mat4& m, const glm::vec3& c, const glm::vec3& s,
+	const VertexSoA& local, VertexSoA& positions, VertexSoA& normals, VertexSoA& light)
+{
+	const size_t count = local.size();
+	for (size_t i = 0; i < count; i++)
+	{
+		const float lx = local.x[i], ly = local.y[i], lz = local.z[i];
+		const float px = m[0][0] * lx + m[1][0] * ly + m[2][0] * lz + m[3][0];
+		const float py = m[0][1] * lx + m[1][1] * ly + m[2][1] * lz + m[3][1];
+		const float pz = m[0][2] * lx + m[1][2] * ly + m[2][2] * lz + m[3][2];
+		positions.x[i] = px;
+		positions.y[i] = py;
+		positions.z[i] = pz;
+
+		const float nx = px - c.x, ny = py - c.y, nz = pz - c.z;
+		const float invNormLength = 1.0f / std::sqrt(nx * nx + ny * ny + nz * nz);
+		normals.x[i] = nx * invNormLength;
+		normals.y[i] = ny * invNormLength;
+		normals.z[i] = nz * invNormLength;
+
+		const float dx = s.x - px, dy = s.y - py, dz = s.z - pz;
+		const float length = std::sqrt(dx * dx + dy * dy + dz * dz);
+		const float scale = kLightScale / (length * std::sqrt(std::sqrt(std::sqrt(length))));
+		light.x[i] = dx * scale;
+		light.y[i] = dy * scale;
+		light.z[i] = dz * scale;
+	}
+}
+
+#if defined(CPU_FEATURES_X86)
+
+static void transformSse(const glm::mat4& m, const glm::vec3& c, const glm::vec3& s,
+	const VertexSoA& local, VertexSoA& positions, VertexSoA& normals, VertexSoA& light)
+{
+	__m128 mat[4][3];
+	for (int col = 0; col < 4; col++)
+		for (int row = 0; row < 3; row++)
+			mat[col][row] = _mm_set1_ps(m[col][row]);
+
+	const __m128 cx = _mm_set1_ps(c.x), cy = _mm_set1_ps(c.y), cz = _mm_set1_ps(c.z);
+	const __m128 sx = _mm_set1_ps(s.x), sy = _mm_set1_ps(s.y), sz = _mm_set1_ps(s.z);
+	const __m128 one = _mm_set1_ps(1.0f), lightScale = _mm_set1_ps(kLightScale);
+
+	// The arrays are padded to a multiple of 8, so of 4 as well
+	const size_t padded = local.x.size();
+	for (size_t i = 0; i < padded; i += 4)
+	{
+		const __m128 lx = _mm_loadu_ps(&local.x[i]), ly = _mm_loadu_ps(&local.y[i]), lz = _mm_loadu_ps(&local.z[i]);
+
+		__m128 p[3];
+		for (int row = 0; row < 3; row++)
+		{
+			p[row] = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(mat[0][row], lx), _mm_mul_ps(mat[1][row], ly)),
+				_mm_add_ps(_mm_mul_ps(mat[2][row], lz), mat[3][row]));
+		}
+		_mm_storeu_ps(&positions.x[i], p[0]);
+		_mm_storeu_ps(&positions.y[i], p[1]);
+		_mm_storeu_ps(&positions.z[i], p[2]);
+
+		const __m128 nx = _mm_sub_ps(p[0], cx), ny = _mm_sub_ps(p[1], cy), nz = _mm_sub_ps(p[2], cz);
+		const __m128 invNormLength = _mm_div_ps(one, _mm_sqrt_ps(
+			_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)), _mm_mul_ps(nz, nz))));
+		_mm_storeu_ps(&normals.x[i], _mm_mul_ps(nx, invNormLength));
+		_mm_storeu_ps(&normals.y[i], _mm_mul_ps(ny, invNormLength));
+		_mm_storeu_ps(&normals.z[i], _mm_mul_ps(nz, invNormLength));
+
+		const __m128 dx = _mm_sub_ps(sx, p[0]), dy = _mm_sub_ps(sy, p[1]), dz = _mm_sub_ps(sz, p[2]);
+		const __m128 length = _mm_sqrt_ps(
+			_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+		const __m128 scale = _mm_div_ps(lightScale,
+			_mm_mul_ps(length, _mm_sqrt_ps(_mm_sqrt_ps(_mm_sqrt_ps(length)))));
+		_mm_storeu_ps(&light.x[i], _mm_mul_ps(dx, scale));
+		_mm_storeu_ps(&light.y[i], _mm_mul_ps(dy, scale));
+		_mm_storeu_ps(&light.z[i], _mm_mul_ps(dz, scale));
+	}
+}
+
+CPU_TARGET_AVX2
+static void transformAvx2(const glm::mat4& m, const glm::vec3& c, const glm::vec3& s,
+	const VertexSoA& local, VertexSoA& positions, VertexSoA& normals, VertexSoA& light)
+{
+	__m256 mat[4][3];
+	for (int col = 0; col < 4; col++)
+		for (int row = 0; row < 3; row++)
+			mat[col][row] = _mm256_set1_ps(m[col][row]);
+
+	const __m256 cx = _mm256_set1_ps(c.x), cy = _mm256_set1_ps(c.y), cz = _mm256_set1_ps(c.z);
+	const __m256 sx = _mm256_set1_ps(s.x), sy = _mm256_set1_ps(s.y), sz = _mm256_set1_ps(s.z);
+	const __m256 one = _mm256_set1_ps(1.0f), lightScale = _mm256_set1_ps(kLightScale);
+
+	const size_t padded = local.x.size();
+	for (size_t i = 0; i < padded; i += 8)
+	{
+		const __m256 lx = _mm256_loadu_ps(&local.x[i]), ly = _mm256_loadu_ps(&local.y[i]), lz = _mm256_loadu_ps(&local.z[i]);
+
+		__m256 p[3];
+		for (int row = 0; row < 3; row++)
+		{
+			p[row] = _mm256_fmadd_ps(mat[0][row], lx,
+				_mm256_fmadd_ps(mat[1][row], ly,
+					_mm256_fmadd_ps(mat[2][row], lz, mat[3][row])));
+		}
+		_mm256_storeu_ps(&positions.x[i], p[0]);
+		_mm256_storeu_ps(&positions.y[i], p[1]);
+		_mm256_storeu_ps(&positions.z[i], p[2]);
+
+		const __m256 nx = _mm256_sub_ps(p[0], cx), ny = _mm256_sub_ps(p[1], cy), nz = _mm256_sub_ps(p[2], cz);
+		const __m256 invNormLength = _mm256_div_ps(one, _mm256_sqrt_ps(
+			_mm256_fmadd_ps(nx, nx, _mm256_fmadd_ps(ny, ny, _mm256_mul_ps(nz, nz)))));
+		_mm256_storeu_ps(&normals.x[i], _mm256_mul_ps(nx, invNormLength));
+		_mm256_storeu_ps(&normals.y[i], _mm256_mul_ps(ny, invNormLength));
+		_mm256_storeu_ps(&normals.z[i], _mm256_mul_ps(nz, invNormLength));
+
+		const __m256 dx = _mm256_sub_ps(sx, p[0]), dy = _mm256_sub_ps(sy, p[1]), dz = _mm256_sub_ps(sz, p[2]);
+		const __m256 length = _mm256_sqrt_ps(
+			_mm256_fmadd_ps(dx, dx, _mm256_fmadd_ps(dy, dy, _mm256_mul_ps(dz, dz))));
+		const __m256 scale = _mm256_div_ps(lightScale,
+			_mm256_mul_ps(length, _mm256_sqrt_ps(_mm256_sqrt_ps(_mm256_sqrt_ps(length)))));
+		_mm256_storeu_ps(&light.x[i], _mm256_mul_ps(dx, scale));
+		_mm256_storeu_ps(&light.y[i], _mm256_mul_ps(dy, scale));
+		_mm256_storeu_ps(&light.z[i], _mm256_mul_ps(dz, scale));
+	}
+}
+
+#endif
+
+VertexKernel::Implementation VertexKernel::detect()
+{
+	if (isSupported(AVX2)) return AVX2;
+	if (isSupported(SSE)) return SSE;
+	return Scalar;
+}
+
+const char* VertexKernel::getName(Implementation implementation)
+{
+	switch (implementation)
+	{
+	case AVX2: return "AVX2";
+	case SSE: return "SSE";
+	default: return "scalar";
+	}
+}
+
+bool VertexKernel::isSupported(Implementation implementation)
+{
+	switch (implementation)
+	{
+#if defined(CPU_FEATURES_X86)
+	case AVX2: return CpuFeatures::hasAvx2();
+	case SSE: return CpuFeatures::hasSse2();
+#endif
+	case Scalar: return true;
+	default: return false;
+	}
+}
+
+void VertexKernel::transform(const glm::mat4& matxTrans, const glm::vec3& selfCenter, const glm::vec3& sunCenter,
+	const VertexSoA& local, VertexSoA& positions, VertexSoA& normals, VertexSoA& light)
+{
+	// The processor does not change while running, detect it only once
+	static const Implementation best = detect();
+	transform(best, matxTrans, selfCenter, sunCenter, local, positions, normals, light);
+}
+
+void VertexKernel::transform(Implementation implementation, const glm::mat4& matxTrans, const glm::vec3& selfCenter, const glm::vec3& sunCenter,
+	const VertexSoA& local, VertexSoA& positions, VertexSoA& normals, VertexSoA& light)
+{
+	switch (implementation)
+	{
+#if defined(CPU_FEATURES_X86)
+	case AVX2:
+		transformAvx2(matxTrans, selfCenter, sunCenter, local, positions, normals, light);
+		break;
+	case SSE:
+		transformSse(matxTrans, selfCenter, sunCenter, local, positions, normals, light);
+		break;
+#endif
+	default:
+		transformScalar(matxTrans, selfCenter, sunCenter, local, positions, normals, light);
+		break;
+	}
+}
@@ -0,0 +1,82 @@
+#ifndef INCLUDE_VERTEXKERNEL
+#define INCLUDE_VERTEXKERNEL
+
+#include <dep/glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+/*
+* @brief Structure-of-arrays storage for vertex attributes: one array per component.
+*
+* The arrays are padded to a multiple of 8 floats so the SIMD kernels never need a remainder loop.
+*/
+struct VertexSoA
+{
+	std::vector<float> x, y, z;
+
+	/*
+	* @brief Resizes the three component arrays.
+	*
+	* @param count The amount of vertices to store.
+	*/
+	void resize(size_t count);
+
+	inline size_t size() const { return m_count; }
+
+	inline void set(size_t i, const glm::vec3& v) { x[i] = v.x; y[i] = v.y; z[i] = v.z; }
+	inline glm::vec3 get(size_t i) const { return glm::vec3(x[i], y[i], z[i]); }
+
+private:
+	size_t m_count = 0;
+};
+
+/*
+* @brief CPU kernel placing local-space vertices in the world and computing their normal and sun light.
+*
+* This is the CPU equivalent of the shaders' placement and lighting. Since the bodies are placed by their model matrix
+* on the GPU, nothing in the application needs world-space vertices on the CPU: only --bench vertex runs it, to measure
+* the SoA SIMD layout against the former per-vertex loop. The fastest implementation supported by the processor is picked at runtime.
+*/
+class VertexKernel
+{
+public:
+	enum Implementation { Scalar, SSE, AVX2 };
+
+	/*
+	* @brief Get the fastest implementation the processor supports.
+	*/
+	static Implementation detect();
+
+	/*
+	* @brief Get the human readable name of an implementation.
+	*/
+	static const char* getName(Implementation implementation);
+
+	/*
+	* @brief Whether the processor can run an implementation.
+	*/
+	static bool isSupported(Implementation implementation);
+
+	/*
+	* @brief Transforms every vertex, and computes its normal and the light it receives from the sun.
+	*
+	* @param matxTrans The local to world transformation.
+	* @param selfCenter The world coordinates of the center of the body, the normals point away from it.
+	* @param sunCenter The world coordinates of the sun.
+	* @param local The local-space positions.
+	* @param positions Receives the world-space positions, must be as large as local.
+	* @param normals Receives the normals, must be as large as local.
+	* @param light Receives the light vectors, must be as large as local.
+	*/
+	static void transform(const glm::mat4& matxTrans, const glm::vec3& selfCenter, const glm::vec3& sunCenter,
+		const VertexSoA& local, VertexSoA& positions, VertexSoA& normals, VertexSoA& light);
+
+	/*
+	* @brief Same as transform(), with a forced implementation. It must be supported.
+	*/
+	static void transform(Implementation implementation, const glm::mat4& matxTrans, const glm::vec3& selfCenter, const glm::vec3& sunCenter,
+		const VertexSoA& local, VertexSoA& positions, VertexSoA& normals, VertexSoA& light);
+};
+
+#endif
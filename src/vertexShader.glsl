@@ -1,26 +1,31 @@
 #version 330 core            // Minimal GL version support expected from the GPU
 
-layout(location=0) in vec3 vPosition;
-layout(location=1) in vec3 vNormal;
-layout(location=2) in vec3 vLight;
-layout(location=3) in vec3 vAmbient;
-layout(location=4) in vec2 vTexCoord;
+layout(location=0) in vec3 vPosition; // Local space, the body is placed by vModelMat
+layout(location=1) in vec3 vNormal;   // Packed as GL_INT_2_10_10_10_REV
+layout(location=4) in vec2 vTexCoord; // Packed as normalized unsigned shorts, u halved
+
+// Per-instance attributes, one set per body
+layout(location=5) in mat4 vModelMat; // Takes locations 5 to 8
+layout(location=9) in float vTextureLayer;
+layout(location=10) in float vEmissive;
 
 // Sent to fragmentShader
 out vec3 fPosition;
 out vec3 fNormal; 
-out vec3 fLight;
-out vec3 fAmbient;
 out vec2 fTexCoord;
+flat out float fTextureLayer;
+flat out float fEmissive;
 
 uniform mat4 viewMat, projMat;
 
 void main() {
-        gl_Position = projMat * viewMat * vec4(vPosition, 1.0); // mandatory to rasterize properly
+        vec4 worldPosition = vModelMat * vec4(vPosition, 1.0);
+        gl_Position = projMat * viewMat * worldPosition; // mandatory to rasterize properly
+
+        fPosition = worldPosition.xyz;
+        fNormal = normalize(mat3(vModelMat) * vNormal); // Bodies are only scaled uniformly
 
-        fPosition = vPosition;
-        fNormal = vNormal;
-        fLight = vLight;
-        fAmbient = vAmbient;
-        fTexCoord = vTexCoord;
+        fTexCoord = vTexCoord * vec2(2.0, 1.0);
+        fTextureLayer = vTextureLayer;
+        fEmissive = vEmissive;
 }